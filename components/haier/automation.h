@@ -34,6 +34,23 @@ public:
 protected:
     HaierClimate* parent_;
 };
+template<typename... Ts> 
+class DumpCaptureAction : public Action<Ts...> 
+{
+public:
+    DumpCaptureAction(HaierClimate* parent, bool clear, bool binary) : parent_(parent), clear_(clear), binary_(binary) {}
+    void play(Ts... x) 
+    {
+        this->parent_->dump_capture(this->binary_);
+        if (this->clear_)
+            this->parent_->clear_capture();
+    }
+
+protected:
+    HaierClimate* parent_;
+    bool clear_;
+    bool binary_;
+};
 
 
 }
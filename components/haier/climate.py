@@ -1,36 +1,200 @@
 ﻿import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import uart, sensor, climate
+import esphome.final_validate as fv
 from esphome import automation
+from esphome.core import CORE
 from esphome.const import (
     CONF_ID,
+    CONF_OPTIMISTIC,
+    CONF_PLATFORM,
     CONF_UART_ID,
     DEVICE_CLASS_TEMPERATURE,
+    ENTITY_CATEGORY_DIAGNOSTIC,
     ICON_THERMOMETER,
     STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
     UNIT_CELSIUS,
+    UNIT_MILLISECOND,
+    UNIT_PERCENT,
 )
 
 AUTO_LOAD = ["sensor"]
 DEPENDENCIES = ["climate", "uart", "wifi"]
 
+CONF_VERIFY_CRC = "verify_crc"
+CONF_CRC_TABLE = "crc_table"
+CONF_MAX_PUBLISH_SILENCE = "max_publish_silence"
+CONF_WARM_UP_TIME = "warm_up_time"
+CONF_PACKET_TIMEOUT = "packet_timeout"
+CONF_ANSWER_TIMEOUT = "answer_timeout"
+CONF_COMMUNICATION_TIMEOUT = "communication_timeout"
+CONF_STATUS_REQUEST_INTERVAL = "status_request_interval"
+CONF_FAST_STATUS_REQUEST_INTERVAL = "fast_status_request_interval"
+CONF_FAST_POLLING_WINDOW = "fast_polling_window"
+CONF_METRICS_UPDATE_INTERVAL = "metrics_update_interval"
+CONF_CAPTURE_BUFFER_SIZE = "capture_buffer_size"
+CONF_WIFI_SIGNAL = "wifi_signal"
+CONF_FRAME_GAP = "frame_gap"
+CONF_RESTORE_STATUS = "restore_status"
+CONF_STATUS_SAVE_INTERVAL = "status_save_interval"
+CONF_RECOVERY_THRESHOLD = "recovery_threshold"
+CONF_RX_TASK = "rx_task"
+CONF_RX_BYTE_BUDGET = "rx_byte_budget"
+CONF_RX_TIME_BUDGET = "rx_time_budget"
+CONF_CLEAR = "clear"
+CONF_FORMAT = "format"
+
+UNIT_MICROSECOND = "µs"
+
+CRC_TABLES = ["FULL", "NIBBLE"]
+CAPTURE_FORMATS = ["HEX", "BINARY"]
+
+# Options generating build wide defines, all haier climates on the node should use the same values
+BUILD_WIDE_OPTIONS = [CONF_CRC_TABLE, CONF_CAPTURE_BUFFER_SIZE, CONF_RX_TASK]
+
 haier_ns = cg.esphome_ns.namespace("haier")
 HaierClimate = haier_ns.class_("HaierClimate", climate.Climate, cg.Component)
+MetricSensors = HaierClimate.enum("MetricSensors")
+
+COUNTER_SENSOR_SCHEMA = sensor.sensor_schema(
+    icon="mdi:counter",
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+# Protocol health sensors
+METRIC_SENSORS = {
+    "checksum_errors": (MetricSensors.msChecksumErrors, COUNTER_SENSOR_SCHEMA),
+    "wrong_size_errors": (MetricSensors.msWrongSizeErrors, COUNTER_SENSOR_SCHEMA),
+    "packet_timeouts": (MetricSensors.msPacketTimeouts, COUNTER_SENSOR_SCHEMA),
+    "answer_timeouts": (MetricSensors.msAnswerTimeouts, COUNTER_SENSOR_SCHEMA),
+    "protocol_resets": (MetricSensors.msProtocolResets, COUNTER_SENSOR_SCHEMA),
+    "recovered_frames": (MetricSensors.msRecoveredFrames, COUNTER_SENSOR_SCHEMA),
+    "rx_overloads": (MetricSensors.msRxOverloads, COUNTER_SENSOR_SCHEMA),
+    "answer_rtt": (
+        MetricSensors.msAnswerRtt,
+        sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon="mdi:timer-outline",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    ),
+    "frame_processing_time": (
+        MetricSensors.msFrameProcessingTime,
+        sensor.sensor_schema(
+            unit_of_measurement=UNIT_MICROSECOND,
+            icon="mdi:timer-outline",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    ),
+    "bus_utilization": (
+        MetricSensors.msBusUtilization,
+        sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            icon="mdi:swap-horizontal",
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    ),
+    "recovery_time": (
+        MetricSensors.msRecoveryTime,
+        sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon="mdi:restore",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    ),
+}
+
+
+def validate_polling(config):
+    if config[CONF_FAST_STATUS_REQUEST_INTERVAL] > config[CONF_STATUS_REQUEST_INTERVAL]:
+        raise cv.Invalid(
+            f"{CONF_FAST_STATUS_REQUEST_INTERVAL} should not be greater than {CONF_STATUS_REQUEST_INTERVAL}"
+        )
+    return config
+
+
+def validate_rx_task(config):
+    if config[CONF_RX_TASK] and not CORE.is_esp32:
+        raise cv.Invalid(f"{CONF_RX_TASK} is supported only on ESP32")
+    return config
+
 
 CONFIG_SCHEMA = cv.All(
     climate.CLIMATE_SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(HaierClimate),
+            cv.Optional(CONF_VERIFY_CRC, default=False): cv.boolean,
+            cv.Optional(CONF_CRC_TABLE, default="FULL"): cv.one_of(*CRC_TABLES, upper=True),
+            cv.Optional(CONF_MAX_PUBLISH_SILENCE, default="60s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_WARM_UP_TIME, default="2s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_PACKET_TIMEOUT, default="500ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_ANSWER_TIMEOUT, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_COMMUNICATION_TIMEOUT, default="60s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_STATUS_REQUEST_INTERVAL, default="5s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_FAST_STATUS_REQUEST_INTERVAL, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_FAST_POLLING_WINDOW, default="10s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_OPTIMISTIC, default=False): cv.boolean,
+            cv.Optional(CONF_METRICS_UPDATE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_WIFI_SIGNAL, default=False): cv.boolean,
+            cv.Optional(CONF_FRAME_GAP, default="10ms"): cv.positive_time_period_milliseconds,
+            # Flash or RTC memory depending on platform restore_from_flash setting
+            cv.Optional(CONF_RESTORE_STATUS, default=True): cv.boolean,
+            cv.Optional(CONF_STATUS_SAVE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_RECOVERY_THRESHOLD, default=3): cv.int_range(min=1, max=255),
+            # Read UART in separate FreeRTOS task, frames are handled in loop()
+            cv.Optional(CONF_RX_TASK, default=False): cv.boolean,
+            # Work limits for one loop() call, the rest of input is handled in the next call
+            cv.Optional(CONF_RX_BYTE_BUDGET, default=256): cv.int_range(min=16, max=4096),
+            cv.Optional(CONF_RX_TIME_BUDGET, default="2ms"): cv.positive_time_period_microseconds,
+            # Raw UART traffic capture in RAM, 0 - disabled
+            cv.Optional(CONF_CAPTURE_BUFFER_SIZE, default=0): cv.Any(
+                cv.one_of(0, int=True), cv.int_range(min=128, max=16384)
+            ),
+        }
+    )
+    .extend(
+        {
+            cv.Optional(name): schema
+            for name, (_, schema) in METRIC_SENSORS.items()
         }
     )
     .extend(uart.UART_DEVICE_SCHEMA)
     .extend(cv.COMPONENT_SCHEMA),
+    validate_polling,
+    validate_rx_task,
 )
 
 
+def final_validate_build_wide_options(config):
+    for other in fv.full_config.get().get("climate", []):
+        if other.get(CONF_PLATFORM) != "haier":
+            continue
+        for option in BUILD_WIDE_OPTIONS:
+            if other.get(option) != config.get(option):
+                raise cv.Invalid(
+                    f"{option} is applied to the whole build and should be the same for all haier climates"
+                )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate_build_wide_options
+
+
 # Actions
 DisplayOnAction = haier_ns.class_("DisplayOnAction", automation.Action)
 DisplayOffAction = haier_ns.class_("DisplayOffAction", automation.Action)
+DumpCaptureAction = haier_ns.class_("DumpCaptureAction", automation.Action)
 # Display on action
 @automation.register_action(
     "climate.haier.display_on",
@@ -61,9 +225,57 @@ async def haier_set_display_off_to_code(config, action_id, template_arg, args):
     var = cg.new_Pvariable(action_id, template_arg, paren)
     return var
 
+# Dump capture action
+@automation.register_action(
+    "climate.haier.dump_capture",
+    DumpCaptureAction,
+    automation.maybe_simple_id(
+        {
+            cv.Required(CONF_ID): cv.use_id(HaierClimate),
+            cv.Optional(CONF_CLEAR, default=False): cv.boolean,
+            # BINARY is compact base64 for host/tools/haier_replay
+            cv.Optional(CONF_FORMAT, default="HEX"): cv.one_of(*CAPTURE_FORMATS, upper=True),
+        }
+    ),
+)
+async def haier_dump_capture_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(
+        action_id, template_arg, paren, config[CONF_CLEAR], config[CONF_FORMAT] == "BINARY"
+    )
+    return var
+
 async def to_code(config):
     uart_component = await cg.get_variable(config[CONF_UART_ID])
     var = cg.new_Pvariable(config[CONF_ID], uart_component)
     await cg.register_component(var, config)
     await uart.register_uart_device(var, config)
     await climate.register_climate(var, config)
+    cg.add(var.set_verify_crc(config[CONF_VERIFY_CRC]))
+    cg.add(var.set_max_publish_silence(config[CONF_MAX_PUBLISH_SILENCE]))
+    cg.add(var.set_warm_up_time(config[CONF_WARM_UP_TIME]))
+    cg.add(var.set_packet_timeout(config[CONF_PACKET_TIMEOUT]))
+    cg.add(var.set_answer_timeout(config[CONF_ANSWER_TIMEOUT]))
+    cg.add(var.set_communication_timeout(config[CONF_COMMUNICATION_TIMEOUT]))
+    cg.add(var.set_status_request_interval(config[CONF_STATUS_REQUEST_INTERVAL]))
+    cg.add(var.set_fast_status_request_interval(config[CONF_FAST_STATUS_REQUEST_INTERVAL]))
+    cg.add(var.set_fast_polling_window(config[CONF_FAST_POLLING_WINDOW]))
+    cg.add(var.set_optimistic(config[CONF_OPTIMISTIC]))
+    cg.add(var.set_metrics_update_interval(config[CONF_METRICS_UPDATE_INTERVAL]))
+    cg.add(var.set_send_wifi_signal(config[CONF_WIFI_SIGNAL]))
+    cg.add(var.set_frame_gap(config[CONF_FRAME_GAP]))
+    cg.add(var.set_restore_status(config[CONF_RESTORE_STATUS]))
+    cg.add(var.set_status_save_interval(config[CONF_STATUS_SAVE_INTERVAL]))
+    cg.add(var.set_recovery_threshold(config[CONF_RECOVERY_THRESHOLD]))
+    cg.add(var.set_rx_byte_budget(config[CONF_RX_BYTE_BUDGET]))
+    cg.add(var.set_rx_time_budget(config[CONF_RX_TIME_BUDGET]))
+    if config[CONF_CAPTURE_BUFFER_SIZE] > 0:
+        cg.add_define("HAIER_CAPTURE_SIZE", config[CONF_CAPTURE_BUFFER_SIZE])
+    for name, (metric, _) in METRIC_SENSORS.items():
+        if name in config:
+            sens = await sensor.new_sensor(config[name])
+            cg.add(var.set_metric_sensor(metric, sens))
+    if config[CONF_RX_TASK]:
+        cg.add_define("HAIER_RX_TASK")
+    if config[CONF_CRC_TABLE] == "NIBBLE":
+        cg.add_define("HAIER_CRC_NIBBLE_TABLE")
@@ -0,0 +1,55 @@
+#include "haier_capture.h"
+
+#ifdef HAIER_CAPTURE_SIZE
+
+namespace esphome {
+namespace haier {
+
+constexpr size_t HaierCapture::MAX_RECORD_DATA;
+
+static_assert(HAIER_CAPTURE_SIZE >= HaierCapture::MAX_RECORD_DATA + 5, "Capture buffer is too small");
+
+HaierCapture::HaierCapture() : mHead(0), mUsed(0)
+{
+}
+
+void HaierCapture::clear()
+{
+    mHead = 0;
+    mUsed = 0;
+}
+
+void HaierCapture::put(uint8_t value)
+{
+    mBuffer[(mHead + mUsed) % HAIER_CAPTURE_SIZE] = value;
+    mUsed++;
+}
+
+void HaierCapture::dropOldest()
+{
+    size_t recordSize = 5 + (mBuffer[mHead] & 0x7F);
+    mHead = (mHead + recordSize) % HAIER_CAPTURE_SIZE;
+    mUsed -= recordSize;
+}
+
+void HaierCapture::record(Directions direction, uint32_t timestamp, const uint8_t* data, size_t size)
+{
+    while (size > 0)
+    {
+        uint8_t chunk = size > MAX_RECORD_DATA ? MAX_RECORD_DATA : size;
+        while (HAIER_CAPTURE_SIZE - mUsed < 5u + chunk)
+            dropOldest();
+        put((direction == cdSent ? 0x80 : 0x00) | chunk);
+        for (int i = 0; i < 4; ++i)
+            put((timestamp >> (8 * i)) & 0xFF);
+        for (uint8_t i = 0; i < chunk; ++i)
+            put(data[i]);
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_CAPTURE_SIZE
@@ -0,0 +1,63 @@
+#ifndef HAIER_CAPTURE_H
+#define HAIER_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esphome/core/defines.h"
+
+#ifdef HAIER_CAPTURE_SIZE
+
+namespace esphome {
+namespace haier {
+
+// Fixed size ring of raw UART traffic. Every record is stored as
+// 1 byte direction and size, 4 bytes timestamp (ms) and data.
+// Oldest records are overwritten when there is not enough space
+class HaierCapture
+{
+public:
+    enum Directions
+    {
+        cdReceived = 0,
+        cdSent,
+    };
+    static constexpr size_t MAX_RECORD_DATA = 64;
+    HaierCapture();
+    void clear();
+    void record(Directions direction, uint32_t timestamp, const uint8_t* data, size_t size);
+    // Calls f(direction, timestamp, data, size) for all records from oldest to newest,
+    // data is copied to temporary buffer because record can wrap around the ring
+    template<typename F>
+    void forEach(F f) const
+    {
+        uint8_t data[MAX_RECORD_DATA];
+        size_t pos = mHead;
+        for (size_t left = mUsed; left > 0;)
+        {
+            uint8_t header = mBuffer[pos];
+            uint8_t size = header & 0x7F;
+            uint32_t timestamp = 0;
+            for (int i = 0; i < 4; ++i)
+                timestamp |= (uint32_t)mBuffer[(pos + 1 + i) % HAIER_CAPTURE_SIZE] << (8 * i);
+            for (uint8_t i = 0; i < size; ++i)
+                data[i] = mBuffer[(pos + 5 + i) % HAIER_CAPTURE_SIZE];
+            f((header & 0x80) ? cdSent : cdReceived, timestamp, data, size);
+            pos = (pos + 5 + size) % HAIER_CAPTURE_SIZE;
+            left -= 5 + size;
+        }
+    }
+    size_t getUsed() const { return mUsed; }
+private:
+    void put(uint8_t value);
+    void dropOldest();
+    uint8_t     mBuffer[HAIER_CAPTURE_SIZE];
+    size_t      mHead;      // Oldest record
+    size_t      mUsed;
+};
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_CAPTURE_SIZE
+
+#endif // HAIER_CAPTURE_H
@@ -1,10 +1,18 @@
-#include "esphome.h"
-#include <chrono>
 #include <string>
+#include <cstring>
+#include "esphome/core/defines.h"
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+#ifdef USE_LOGGER
+#include "esphome/components/logger/logger.h"
+#endif
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/uart/uart.h"
 #include "haier_climate.h"
-#include "haier_packet.h"
+#include "haier_protocol.h"
+#include "haier_climate_state.h"
+#include "haier_crc.h"
+#include "haier_frame_decoder.h"
 #include "esphome/components/wifi/wifi_component.h"
 
 using namespace esphome::climate;
@@ -15,18 +23,60 @@ namespace haier {
 
 #define TAG "Haier"
 
+// Default timings, can be changed from configuration
 #define PACKET_TIMOUT_MS                500
 #define ANSWER_TIMOUT_MS                1000
 #define COMMUNICATION_TIMOUT_MS         60000
 #define STATUS_REQUEST_INTERVAL_MS      5000
+#define FAST_STATUS_REQUEST_INTERVAL_MS 1000
+#define FAST_POLLING_WINDOW_MS          10000
+#define WARM_UP_TIME_MS                 2000
+#define METRICS_UPDATE_INTERVAL_MS      60000
 #define SIGNAL_LEVEL_UPDATE_INTERVAL_MS 10000
+#define FRAME_GAP_MS                    10
+#define DEFAULT_MAX_PUBLISH_SILENCE_MS  60000
+#define STATUS_SAVE_INTERVAL_MS         60000
+
+// Mixed with entity hash, climate base class uses plain hash for its own state
+#define STATUS_PREFERENCE_HASH          0x48414952
+
+// How many times control packet is resent if AC didn't apply it
+#define CONTROL_RETRIES                 3
+
+// Consecutive answer timeouts or broken frames before decoder is flushed and protocol resynchronized
+#define RECOVERY_THRESHOLD              3
+// First status request is retried with exponential backoff starting from answer timeout
+#define FIRST_STATUS_RETRY_MAX_MS       30000
+
+#ifdef HAIER_RX_TASK
+// Bytes, leaves room for UART driver calls under read_array() with stack checking enabled
+#define RX_TASK_STACK_SIZE              3072
+// Above main loop task, so slow loop iterations don't delay reading
+#define RX_TASK_PRIORITY                5
+#endif
 
 // temperatures supported by AC system
 #define MIN_SET_TEMPERATURE             16
 #define MAX_SET_TEMPERATURE             30
 
-#define MAX_MESSAGE_SIZE                64
-#define HEADER                          0xFF
+#define HEX_BUFFER_SIZE                 (HaierProtocol::MAX_FRAME_SIZE * 3 + 1)
+
+// AC could confirm signal report, don't send anything else during this time
+#define SIGNAL_ANSWER_WINDOW_MS         200
+
+// Line time of one byte, 10 bits at 9600 baud
+#define BYTE_TRANSFER_TIME_US           1042
+
+// Frame is 0xFF 0xFF, message, checksum and optional CRC16
+#define FRAME_PREFIX_SIZE               2
+#define FRAME_OVERHEAD                  (FRAME_PREFIX_SIZE + 3)
+
+// Default limits for reading and handling input in one loop() call
+#define RX_BYTE_BUDGET                  256
+#define RX_TIME_BUDGET_US               2000
+
+// Identical status answers are logged only once per this number of answers
+#define STATUS_LOG_REPEAT_INTERVAL      12
 
 // ESP_LOG_LEVEL don't work as I want it so I implemented this macro
 #define ESP_LOG_L(level, tag, format, ...) do {                     \
@@ -40,120 +90,449 @@ namespace haier {
 
 uint8_t getChecksum(const uint8_t * message, size_t size) {
         uint8_t result = 0;
-        for (int i = 0; i < size; i++){
+        for (size_t i = 0; i < size; i++){
             result += message[i];
         }
         return result;
     }
 
-unsigned short crc16(const uint8_t* message, int len, uint16_t initial_val = 0)
+// Check if message with this level will be emitted at all, to skip formatting otherwise.
+// Besides compile time level, level of the tag can be lowered by logger: logs: or at runtime
+bool isLogLevelEnabled(int level)
 {
-    constexpr uint16_t poly = 0xA001;
-    uint16_t crc = initial_val;
-    for(int i = 0; i < len; ++i)
-    {
-        crc ^= (unsigned short)message[i];
-        for(int b = 0; b < 8; ++b)
-        {
-            if((crc & 1) != 0)
-            {
-                crc >>= 1;
-                crc ^= poly;
-            }
-            else
-                crc >>= 1;
-
-        }
-    }
-    return crc;
+    if (level > ESPHOME_LOG_LEVEL)
+        return false;
+#ifdef USE_LOGGER
+    if (logger::global_logger != NULL)
+        return level <= logger::global_logger->level_for(TAG);
+#endif
+    return true;
 }
 
-std::string getHex(const uint8_t * message, size_t size)
+// Writes " XX" for every byte into buffer, returns number of message bytes that fit
+size_t getHex(char* buffer, size_t bufferSize, const uint8_t * message, size_t size)
 {
     constexpr char hexmap[] = { '0', '1', '2', '3', '4', '5', '6', '7',
                                 '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
-    std::string raw(size * 3, ' ');
-    for (int i = 0; i < size; ++i) {
-        raw[3*i]   = ' ';
-        raw[3*i+1] = hexmap[(message[i] & 0xF0) >> 4];
-        raw[3*i+2] = hexmap[message[i] & 0x0F];
+    if (bufferSize == 0)
+        return 0;
+    size_t count = (bufferSize - 1) / 3;
+    if (count > size)
+        count = size;
+    for (size_t i = 0; i < count; ++i) {
+        buffer[3*i]   = ' ';
+        buffer[3*i+1] = hexmap[(message[i] & 0xF0) >> 4];
+        buffer[3*i+2] = hexmap[message[i] & 0x0F];
     }
-  return raw;
+    buffer[3*count] = '\0';
+    return count;
 }
 
-namespace
+#ifdef HAIER_CAPTURE_SIZE
+// Raw capture bytes in one line of binary dump, 64 base64 characters
+#define CAPTURE_CHUNK_SIZE              48
+#define BASE64_BUFFER_SIZE              ((CAPTURE_CHUNK_SIZE + 2) / 3 * 4 + 1)
+
+// Writes data as base64 (with padding), returns number of characters written
+size_t getBase64(char* buffer, size_t bufferSize, const uint8_t* data, size_t size)
 {
-    enum HaierProtocolCommands
+    constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    if ((bufferSize == 0) || ((size + 2) / 3 * 4 >= bufferSize))
+    {
+        if (bufferSize > 0)
+            buffer[0] = '\0';
+        return 0;
+    }
+    size_t pos = 0;
+    for (size_t i = 0; i < size; i += 3)
     {
-        hpCommandStatus             = 0x01,
+        uint32_t triple = (uint32_t)data[i] << 16;
+        if (i + 1 < size)
+            triple |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < size)
+            triple |= data[i + 2];
+        buffer[pos++] = alphabet[(triple >> 18) & 0x3F];
+        buffer[pos++] = alphabet[(triple >> 12) & 0x3F];
+        buffer[pos++] = i + 1 < size ? alphabet[(triple >> 6) & 0x3F] : '=';
+        buffer[pos++] = i + 2 < size ? alphabet[triple & 0x3F] : '=';
+    }
+    buffer[pos] = '\0';
+    return pos;
+}
+#endif
+
+HaierClimate::HaierClimate(UARTComponent* parent) :
+                                        Component(),
+                                        UARTDevice(parent),
+                                        mClock(millis),
+                                        mPhase(psWarmingUp),
+                                        mControlContext(HaierProtocol::INITIAL_CONTROL_CONTEXT),
+                                        mDisplayStatus(true),
+                                        mControlPending(false),
+                                        mControlRequestChanged(false),
+                                        mControlRetries(0),
+                                        mOptimistic(false),
+                                        mOptimisticPending(false),
+                                        mRepeatedStatusCounter(0),
+                                        mMaxPublishSilence(DEFAULT_MAX_PUBLISH_SILENCE_MS),
+                                        mWarmUpTime(WARM_UP_TIME_MS),
+                                        mPacketTimeout(PACKET_TIMOUT_MS),
+                                        mAnswerTimeout(ANSWER_TIMOUT_MS),
+                                        mCommunicationTimeout(COMMUNICATION_TIMOUT_MS),
+                                        mStatusRequestInterval(STATUS_REQUEST_INTERVAL_MS),
+                                        mFastStatusRequestInterval(FAST_STATUS_REQUEST_INTERVAL_MS),
+                                        mFastPollingWindow(FAST_POLLING_WINDOW_MS),
+                                        mSendWifiSignal(false),
+                                        mRestoreStatus(false),
+                                        mStatusSavePending(false),
+                                        mSavedStatusCrc(0),
+                                        mStatusSaveInterval(STATUS_SAVE_INTERVAL_MS),
+                                        mFrameGap(FRAME_GAP_MS),
+                                        mLogStatistics{0, 0},
+                                        mPublishStatistics{0, 0, 0},
+                                        mOptimisticStatistics{0, 0, 0, 0},
+                                        mProtocolStatistics{},
+                                        mMetricSensors{},
+                                        mMetricsUpdateInterval(METRICS_UPDATE_INTERVAL_MS),
+                                        mReportedAnswers(0),
+                                        mReportedRttTotal(0),
+                                        mReportedFrames(0),
+                                        mReportedProcessingTime(0),
+                                        mReportedBusBytes(0),
+                                        mReportedRecoveries(0),
+                                        mRecoveryThreshold(RECOVERY_THRESHOLD),
+                                        mRxByteBudget(RX_BYTE_BUDGET),
+                                        mRxTimeBudget(RX_TIME_BUDGET_US),
+                                        mConsecutiveFailures(0),
+                                        mLastFrameErrors(0),
+                                        mLoggedDecoderStatistics{0, 0, 0, 0, 0},
+                                        mFirstStatusRetryInterval(ANSWER_TIMOUT_MS),
+                                        mSetupTimestamp(0),
+                                        mLastByteTimestamp(0),
+                                        mLastRequestTimestamp(0),
+                                        mLastValidStatusTimestamp(0),
+                                        mLastPublishTimestamp(0),
+                                        mFastPollingEnd(0),
+                                        mFastPolling(false),
+                                        mOptimisticTimestamp(0),
+                                        mLastMetricsUpdate(0),
+                                        mLastStatusRequest(0),
+                                        mLastSignalRequest(0),
+                                        mLastStatusSave(0),
+                                        mFaultTimestamp(0),
+#ifdef HAIER_RX_TASK
+                                        mRxTask(NULL),
+                                        mRxResetRequest(false),
+                                        mRxReceiving(false),
+#endif
+                                        mLineFreeTimestamp(0),
+                                        mNextDeadline(0)
+{
+}
+
+bool HaierClimate::get_display_state() const
+{
+    return mDisplayStatus;
+}
+
+const HaierClimate::LogStatistics& HaierClimate::get_log_statistics() const
+{
+    return mLogStatistics;
+}
+
+void HaierClimate::set_verify_crc(bool verify)
+{
+    mDecoder.setVerifyCrc(verify);
+}
+
+const HaierFrameDecoder::Statistics& HaierClimate::get_decoder_statistics() const
+{
+    return mDecoder.getStatistics();
+}
+
+void HaierClimate::set_max_publish_silence(uint32_t silence_ms)
+{
+    mMaxPublishSilence = silence_ms;
+}
+
+const HaierClimate::PublishStatistics& HaierClimate::get_publish_statistics() const
+{
+    return mPublishStatistics;
+}
+
+void HaierClimate::set_warm_up_time(uint32_t time_ms)
+{
+    mWarmUpTime = time_ms;
+}
+
+void HaierClimate::set_packet_timeout(uint32_t timeout_ms)
+{
+    mPacketTimeout = timeout_ms;
+}
+
+void HaierClimate::set_answer_timeout(uint32_t timeout_ms)
+{
+    mAnswerTimeout = timeout_ms;
+}
+
+void HaierClimate::set_communication_timeout(uint32_t timeout_ms)
+{
+    mCommunicationTimeout = timeout_ms;
+}
+
+void HaierClimate::set_status_request_interval(uint32_t interval_ms)
+{
+    mStatusRequestInterval = interval_ms;
+}
+
+void HaierClimate::set_fast_status_request_interval(uint32_t interval_ms)
+{
+    mFastStatusRequestInterval = interval_ms;
+}
+
+void HaierClimate::set_fast_polling_window(uint32_t window_ms)
+{
+    mFastPollingWindow = window_ms;
+}
+
+void HaierClimate::set_optimistic(bool optimistic)
+{
+    mOptimistic = optimistic;
+}
+
+void HaierClimate::set_send_wifi_signal(bool send)
+{
+    mSendWifiSignal = send;
+}
+
+void HaierClimate::set_frame_gap(uint32_t gap_ms)
+{
+    mFrameGap = gap_ms;
+}
+
+void HaierClimate::set_recovery_threshold(uint8_t failures)
+{
+    mRecoveryThreshold = failures;
+}
+
+void HaierClimate::set_rx_byte_budget(uint32_t bytes)
+{
+    mRxByteBudget = bytes;
+}
+
+void HaierClimate::set_rx_time_budget(uint32_t time_us)
+{
+    mRxTimeBudget = time_us;
+}
+
+void HaierClimate::set_clock(ClockFunction clock)
+{
+    mClock = clock;
+}
+
+void HaierClimate::set_restore_status(bool restore)
+{
+    mRestoreStatus = restore;
+}
+
+void HaierClimate::set_status_save_interval(uint32_t interval_ms)
+{
+    mStatusSaveInterval = interval_ms;
+}
+
+const HaierClimate::OptimisticStatistics& HaierClimate::get_optimistic_statistics() const
+{
+    return mOptimisticStatistics;
+}
+
+constexpr uint16_t HaierClimate::RTT_HISTOGRAM_BOUNDS[];
+
+const HaierClimate::ProtocolStatistics& HaierClimate::get_protocol_statistics() const
+{
+    return mProtocolStatistics;
+}
+
+void HaierClimate::set_metric_sensor(MetricSensors metric, sensor::Sensor* sensor)
+{
+    if (metric < msCount)
+        mMetricSensors[metric] = sensor;
+}
+
+void HaierClimate::set_metrics_update_interval(uint32_t interval_ms)
+{
+    mMetricsUpdateInterval = interval_ms;
+}
+
+void HaierClimate::recordAnswerTime(uint32_t now)
+{
+    uint32_t rtt = now - mLastRequestTimestamp;
+    size_t bucket = 0;
+    while ((bucket < RTT_HISTOGRAM_SIZE - 1) && (rtt > RTT_HISTOGRAM_BOUNDS[bucket]))
+        bucket++;
+    mProtocolStatistics.rttHistogram[bucket]++;
+    mProtocolStatistics.rttTotal += rtt;
+    mProtocolStatistics.answers++;
+}
+
+void HaierClimate::publishMetrics(uint32_t elapsed)
+{
+    const HaierFrameDecoder::Statistics& decoderStatistics = mDecoder.getStatistics();
+    const uint32_t values[msAnswerRtt] = {
+        decoderStatistics.checksumErrors + decoderStatistics.crcErrors,
+        decoderStatistics.wrongSizeErrors,
+        mProtocolStatistics.packetTimeouts,
+        mProtocolStatistics.answerTimeouts,
+        mProtocolStatistics.protocolResets,
+        decoderStatistics.recoveredFrames,
+        mProtocolStatistics.rxOverloads,
     };
+    for (size_t i = 0; i < msAnswerRtt; ++i)
+        if (mMetricSensors[i] != NULL)
+            mMetricSensors[i]->publish_state(values[i]);
+    // Averages since last update
+    uint32_t answers = mProtocolStatistics.answers - mReportedAnswers;
+    if ((mMetricSensors[msAnswerRtt] != NULL) && (answers > 0))
+        mMetricSensors[msAnswerRtt]->publish_state((float)(mProtocolStatistics.rttTotal - mReportedRttTotal) / answers);
+    uint32_t frames = mProtocolStatistics.rxFrames - mReportedFrames;
+    if ((mMetricSensors[msFrameProcessingTime] != NULL) && (frames > 0))
+        mMetricSensors[msFrameProcessingTime]->publish_state((float)(mProtocolStatistics.rxProcessingTime - mReportedProcessingTime) / frames);
+    uint32_t busBytes = mProtocolStatistics.rxBytes + mProtocolStatistics.txBytes;
+    if ((mMetricSensors[msBusUtilization] != NULL) && (elapsed > 0))
+        mMetricSensors[msBusUtilization]->publish_state((float)(busBytes - mReportedBusBytes) * BYTE_TRANSFER_TIME_US / 10 / elapsed);
+    mReportedAnswers = mProtocolStatistics.answers;
+    mReportedRttTotal = mProtocolStatistics.rttTotal;
+    mReportedFrames = mProtocolStatistics.rxFrames;
+    mReportedProcessingTime = mProtocolStatistics.rxProcessingTime;
+    mReportedBusBytes = busBytes;
+    if ((mMetricSensors[msRecoveryTime] != NULL) && (mProtocolStatistics.recoveries != mReportedRecoveries))
+        mMetricSensors[msRecoveryTime]->publish_state(mProtocolStatistics.lastRecoveryTime);
+    mReportedRecoveries = mProtocolStatistics.recoveries;
+}
+
+// Only broken frames count as failures. Wrong size header is mostly 0xFF 0xFF in line noise
+// and is skipped by decoder anyway, it is not a reason to resynchronize
+uint32_t HaierClimate::getFrameErrors() const
+{
+    const HaierFrameDecoder::Statistics& decoderStatistics = mDecoder.getStatistics();
+    return decoderStatistics.checksumErrors + decoderStatistics.crcErrors;
+}
+
+// Decoder only counts errors, they are logged here from loop() and not from RX task
+void HaierClimate::logDecoderErrors()
+{
+    const HaierFrameDecoder::Statistics current = mDecoder.getStatistics();
+    const HaierFrameDecoder::Statistics& logged = mLoggedDecoderStatistics;
+    if (current.checksumErrors != logged.checksumErrors)
+        ESP_LOGW(TAG, "Wrong packet checksum in %u frames", current.checksumErrors - logged.checksumErrors);
+    if (current.crcErrors != logged.crcErrors)
+        ESP_LOGW(TAG, "Wrong packet CRC in %u frames", current.crcErrors - logged.crcErrors);
+    if (current.wrongSizeErrors != logged.wrongSizeErrors)
+        ESP_LOGW(TAG, "Wrong packet size in %u headers", current.wrongSizeErrors - logged.wrongSizeErrors);
+    if (current.recoveredFrames != logged.recoveredFrames)
+        ESP_LOGD(TAG, "%u frames recovered after resynchronization", current.recoveredFrames - logged.recoveredFrames);
+    mLoggedDecoderStatistics = current;
+}
 
-    enum HaierProtocolAnswers
+void HaierClimate::registerFailure(uint32_t now)
+{
+    if (mConsecutiveFailures == 0)
+        mFaultTimestamp = now;
+    if (mConsecutiveFailures < UINT8_MAX)
+        mConsecutiveFailures++;
+    // Before first status decoder is reset on every retry anyway
+    if ((mConsecutiveFailures == mRecoveryThreshold) && (mPhase >= psIdle))
     {
-        hpAnswerRequestStatus       = 0x02,
-        hpAnswerError               = 0x03,
-    };
+        ESP_LOGW(TAG, "%d consecutive failures, resynchronizing", mConsecutiveFailures);
+        mProtocolStatistics.resyncs++;
+        resetDecoder();
+        mFirstStatusRetryInterval = mAnswerTimeout;
+        mPhase = psSendingFirstStatusRequest;
+    }
 }
 
-const HaierPacketHeader poll_command = {
-        .msg_length = 0x0A,
-        .reserved = { 0x00,   0x00,   0x00,   0x00,   0x00,   0x01 },
-        .msg_type = (uint8_t)(hpCommandStatus),
-        .arguments = { 0x4D, 0x01 }
-    };
+void HaierClimate::registerRecovery(uint32_t now)
+{
+    mFirstStatusRetryInterval = mAnswerTimeout;
+    if (mConsecutiveFailures == 0)
+        return;
+    uint32_t recoveryTime = now - mFaultTimestamp;
+    mProtocolStatistics.recoveries++;
+    mProtocolStatistics.lastRecoveryTime = recoveryTime;
+    if (recoveryTime > mProtocolStatistics.maxRecoveryTime)
+        mProtocolStatistics.maxRecoveryTime = recoveryTime;
+    ESP_LOGI(TAG, "Communication recovered after %d failures in %u ms", mConsecutiveFailures, recoveryTime);
+    mConsecutiveFailures = 0;
+}
 
-const HaierPacketHeader control_command = {
-        .msg_length = CONTROL_PACKET_SIZE,
-        .reserved = { 0x00,   0x00,   0x00,   0x00,   0x00,   0x01 },
-        .msg_type = (uint8_t)(hpCommandStatus),
-        .arguments = { 0x4D, 0x5F }
+void HaierClimate::dump_capture(bool binary)
+{
+#ifdef HAIER_CAPTURE_SIZE
+    if (!binary)
+    {
+        ESP_LOGI(TAG, "UART capture, %u bytes used", (unsigned)mCapture.getUsed());
+        mCapture.forEach([](HaierCapture::Directions direction, uint32_t timestamp, const uint8_t* data, uint8_t size)
+        {
+            char raw[HEX_BUFFER_SIZE];
+            getHex(raw, sizeof(raw), data, size);
+            ESP_LOGI(TAG, "Capture %u %s:%s", timestamp, direction == HaierCapture::cdSent ? "TX" : "RX", raw);
+        });
+        return;
+    }
+    // Records in the same layout as in capture buffer (direction and size, timestamp, data),
+    // split into base64 lines. Decoded by host/tools/haier_replay
+    ESP_LOGI(TAG, "UART capture, %u bytes used, binary", (unsigned)mCapture.getUsed());
+    uint8_t chunk[CAPTURE_CHUNK_SIZE];
+    size_t chunkSize = 0;
+    auto put = [&chunk, &chunkSize](uint8_t value)
+    {
+        chunk[chunkSize++] = value;
+        if (chunkSize == sizeof(chunk))
+        {
+            char line[BASE64_BUFFER_SIZE];
+            getBase64(line, sizeof(line), chunk, chunkSize);
+            ESP_LOGI(TAG, "Capture B64:%s", line);
+            chunkSize = 0;
+        }
     };
-
-HaierClimate::HaierClimate(UARTComponent* parent) :
-                                        Component(),
-                                        UARTDevice(parent),
-                                        mFanModeFanSpeed(FanMid),
-                                        mOtherModesFanSpeed(FanAuto)
-{
-    mLastPacket = new uint8_t[MAX_MESSAGE_SIZE];
-    mTraits = climate::ClimateTraits();
-    mTraits.set_supported_modes(
-    {
-        climate::CLIMATE_MODE_OFF,
-        climate::CLIMATE_MODE_COOL,
-        climate::CLIMATE_MODE_HEAT,
-        climate::CLIMATE_MODE_FAN_ONLY,
-        climate::CLIMATE_MODE_DRY,
-        climate::CLIMATE_MODE_AUTO
-    });
-    mTraits.set_supported_fan_modes(
+    mCapture.forEach([&put](HaierCapture::Directions direction, uint32_t timestamp, const uint8_t* data, uint8_t size)
     {
-        climate::CLIMATE_FAN_AUTO,
-        climate::CLIMATE_FAN_LOW,
-        climate::CLIMATE_FAN_MEDIUM,
-        climate::CLIMATE_FAN_HIGH,
+        put((direction == HaierCapture::cdSent ? 0x80 : 0x00) | size);
+        for (int i = 0; i < 4; ++i)
+            put((timestamp >> (8 * i)) & 0xFF);
+        for (uint8_t i = 0; i < size; ++i)
+            put(data[i]);
     });
-    mTraits.set_supported_swing_modes(
+    if (chunkSize > 0)
     {
-        climate::CLIMATE_SWING_OFF,
-        climate::CLIMATE_SWING_BOTH,
-        climate::CLIMATE_SWING_VERTICAL,
-        climate::CLIMATE_SWING_HORIZONTAL
-    });
-    mTraits.set_visual_min_temperature(MIN_SET_TEMPERATURE);
-    mTraits.set_visual_max_temperature(MAX_SET_TEMPERATURE);
-    mTraits.set_visual_temperature_step(1.0f);
-    mTraits.set_supports_current_temperature(true);
+        char line[BASE64_BUFFER_SIZE];
+        getBase64(line, sizeof(line), chunk, chunkSize);
+        ESP_LOGI(TAG, "Capture B64:%s", line);
+    }
+    ESP_LOGI(TAG, "Capture end");
+#else
+    ESP_LOGW(TAG, "UART capture is disabled");
+#endif
 }
 
-HaierClimate::~HaierClimate()
+void HaierClimate::clear_capture()
 {
-    delete[] mLastPacket;
+#ifdef HAIER_CAPTURE_SIZE
+    mCapture.clear();
+#endif
 }
 
-bool HaierClimate::get_display_state() const
+void HaierClimate::startFastPolling()
 {
-    return mDisplayStatus;
+    if (mFastPollingWindow > 0)
+    {
+        mFastPollingEnd = mClock() + mFastPollingWindow;
+        mFastPolling = true;
+    }
+}
+
+bool HaierClimate::get_last_status(uint8_t* buffer, size_t size) const
+{
+    return mLastStatus.read(buffer, 0, size);
 }
 
 void HaierClimate::set_display_state(bool state)
@@ -161,222 +540,634 @@ void HaierClimate::set_display_state(bool state)
     if (mDisplayStatus != state)
     {
         mDisplayStatus = state;
-        mForceSendControl = true;
+        mControlPending = true;
+        // Control packet in flight could be built with the old display state
+        mControlRequestChanged = true;
+        mControlRetries = 0;
+        startFastPolling();
     }
 }
 void HaierClimate::setup()
 {
     ESP_LOGI(TAG, "Haier initialization...");
-    delay(2000); // Give time for AC to boot
-    mPhase = psSendingFirstStatusRequest;
+    // Give time for AC to boot, protocol starts in loop() when warm up time passed
+    uint32_t now = mClock();
+    mSetupTimestamp = now;
+    // Timestamps are compared as signed differences, so they should start from current time,
+    // not from 0 which could be more than 2^31 ms away
+    mNextDeadline = now;
+    mLineFreeTimestamp = now;
+    mLastMetricsUpdate = now;
+    mLastSignalRequest = now;
+    mLastStatusSave = now;
+    mPhase = psWarmingUp;
+    mFirstStatusRetryInterval = mAnswerTimeout;
+#ifdef HAIER_RX_TASK
+    if (xTaskCreate(rxTask, "haier_rx", RX_TASK_STACK_SIZE, this, RX_TASK_PRIORITY, &mRxTask) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Can't create RX task");
+        mark_failed();
+        return;
+    }
+#endif
+    if (mRestoreStatus)
+        restoreStatus();
 }
 
-namespace   // anonymous namespace for local things
+void HaierClimate::restoreStatus()
 {
-    struct CurrentPacketStatus
+    mStatusPreference = global_preferences->make_preference<StoredStatus>(get_object_id_hash() ^ STATUS_PREFERENCE_HASH);
+    StoredStatus stored;
+    if (!mStatusPreference.load(&stored) ||
+        (HaierProtocol::getAnswerType(stored.data) != HaierProtocol::atStatus) ||
+        (HaierProtocol::getMessageSize(stored.data) < HaierProtocol::CONTROL_PACKET_SIZE))
     {
-        uint8_t buffer[MAX_MESSAGE_SIZE];
-        uint8_t preHeaderCharsCounter;
-        uint8_t size;
-        uint8_t position;
-        uint8_t checksum;
-        CurrentPacketStatus() : preHeaderCharsCounter(0),
-                                size(0),
-                                position(0),
-                                checksum(0)
-        {};
-        void Reset()
-        {
-            size = 0;
-            position = 0;
-            checksum = 0;
-            preHeaderCharsCounter = 0;
-        };
-    };
+        ESP_LOGI(TAG, "No stored status");
+        return;
+    }
+    mSavedStatusCrc = HaierProtocol::getSettingsCrc(stored.data, sizeof(stored.data));
+    // Provisional state, replaced by first status answer.
+    // Not used as a base for control packets, they are sent only after AC answered
+    ESP_LOGI(TAG, "Publishing stored status");
+    processStatus(stored.data, sizeof(stored.data));
+}
 
-    CurrentPacketStatus currentPacket;
+void HaierClimate::saveStatus(uint32_t now)
+{
+    mStatusSavePending = false;
+    mLastStatusSave = now;
+    StoredStatus stored;
+    if (!mLastStatus.read(stored.data, 0, sizeof(stored.data)))
+        return;
+    uint16_t crc = HaierProtocol::getSettingsCrc(stored.data, sizeof(stored.data));
+    if (crc == mSavedStatusCrc)
+        return;
+    if (mStatusPreference.save(&stored))
+    {
+        mSavedStatusCrc = crc;
+        ESP_LOGD(TAG, "Status saved");
+    }
+}
+
+void HaierClimate::dump_config()
+{
+    ESP_LOGCONFIG(TAG, "Haier AC:");
+    ESP_LOGCONFIG(TAG, "  Status request interval: %u ms, fast: %u ms", mStatusRequestInterval, mFastStatusRequestInterval);
+    ESP_LOGCONFIG(TAG, "  Optimistic: %s", mOptimistic ? "yes" : "no");
+    ESP_LOGCONFIG(TAG, "  WiFi signal reports: %s", mSendWifiSignal ? "yes" : "no");
+    // All buffers are members, so this is the whole footprint except shared traits and CRC table
+    ESP_LOGCONFIG(TAG, "  RAM per instance: %u bytes", (unsigned)sizeof(HaierClimate));
+    ESP_LOGCONFIG(TAG, "    Frame decoder: %u bytes", (unsigned)sizeof(HaierFrameDecoder));
+    ESP_LOGCONFIG(TAG, "    Status snapshot: %u bytes", (unsigned)sizeof(HaierStatusSnapshot));
+#ifdef HAIER_CAPTURE_SIZE
+    ESP_LOGCONFIG(TAG, "    UART capture: %u bytes", (unsigned)sizeof(HaierCapture));
+#endif
+#ifdef USE_ESP8266
+    ESP_LOGCONFIG(TAG, "  CRC table, shared, in flash: %u bytes", (unsigned)sizeof(CRC16_TABLE));
+#else
+    ESP_LOGCONFIG(TAG, "  CRC table, shared: %u bytes", (unsigned)sizeof(CRC16_TABLE));
+#endif
+}
+
+namespace
+{
+    // Keep earlier of two timestamps, handles clock overflow
+    void setEarlier(uint32_t& deadline, uint32_t timestamp)
+    {
+        if ((int32_t)(timestamp - deadline) < 0)
+            deadline = timestamp;
+    }
 
+    void setLater(uint32_t& deadline, uint32_t timestamp)
+    {
+        if ((int32_t)(timestamp - deadline) > 0)
+            deadline = timestamp;
+    }
 }
 
 void HaierClimate::loop()
 {
-    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
-    if ((mPhase >= psIdle) && (std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastValidStatusTimestamp).count() > COMMUNICATION_TIMOUT_MS))
+    uint32_t now = mClock();
+    mProtocolStatistics.loopCalls++;
+    // Nothing is due yet and there is nothing to read or send
+    if (((int32_t)(now - mNextDeadline) < 0) && !(mControlPending && (mPhase == psIdle) && isLineFree(now)) && !hasInput())
+        return;
+    uint32_t start = micros();
+    processProtocol(now);
+    mNextDeadline = getNextDeadline(now);
+    mProtocolStatistics.activeLoopCalls++;
+    mProtocolStatistics.activeLoopTime += micros() - start;
+}
+
+uint32_t HaierClimate::getNextDeadline(uint32_t now) const
+{
+    // All timeouts trigger when time passed is greater than interval
+    uint32_t deadline = mLastMetricsUpdate + mMetricsUpdateInterval + 1;
+    switch (mPhase)
+    {
+        case psWarmingUp:
+            setEarlier(deadline, mSetupTimestamp + mWarmUpTime + 1);
+            break;
+        case psWaitingFirstStatusAnswer:
+            setEarlier(deadline, mLastRequestTimestamp + mFirstStatusRetryInterval + 1);
+            break;
+        case psWaitingStatusAnswer:
+        case psWaitingControlAnswer:
+            setEarlier(deadline, mLastRequestTimestamp + mAnswerTimeout + 1);
+            break;
+        case psSendingFirstStatusRequest:
+            if (isLineFree(now))
+                return now;
+            setEarlier(deadline, mLineFreeTimestamp);
+            break;
+        case psIdle:
+        {
+            uint32_t due = mControlPending ? now : mLastStatusRequest + mStatusRequestInterval + 1;
+            if (mFastPolling)
+                setEarlier(due, mLastStatusRequest + mFastStatusRequestInterval + 1);
+            if (mSendWifiSignal)
+                setEarlier(due, mLastSignalRequest + SIGNAL_LEVEL_UPDATE_INTERVAL_MS + 1);
+            // Message can't be sent before line is free
+            if ((int32_t)(due - mLineFreeTimestamp) < 0)
+                due = mLineFreeTimestamp;
+            setEarlier(deadline, due);
+            break;
+        }
+        default:
+            // Something should be sent right away
+            return now;
+    }
+    if (mPhase >= psIdle)
+        setEarlier(deadline, mLastValidStatusTimestamp + mCommunicationTimeout + 1);
+    if (mStatusSavePending)
+        setEarlier(deadline, mLastStatusSave + mStatusSaveInterval + 1);
+#ifndef HAIER_RX_TASK
+    if (mDecoder.isReceiving())
+        setEarlier(deadline, mLastByteTimestamp + mPacketTimeout + 1);
+#endif
+    return deadline;
+}
+
+void HaierClimate::processProtocol(uint32_t now)
+{
+    if ((mPhase >= psIdle) && ((now - mLastValidStatusTimestamp) > mCommunicationTimeout))
     {
         ESP_LOGE(TAG, "No valid status answer for to long. Resetting protocol");
-        currentPacket.Reset();
+        mProtocolStatistics.protocolResets++;
+        resetDecoder();
         mPhase = psSendingFirstStatusRequest;
         return;
     }
+    if ((now - mLastMetricsUpdate) > mMetricsUpdateInterval)
+    {
+        uint32_t elapsed = now - mLastMetricsUpdate;
+        mLastMetricsUpdate = now;
+        publishMetrics(elapsed);
+    }
+    // Window end is compared only while it is close, stale timestamp would look like future after 2^31 ms
+    if (mFastPolling && ((int32_t)(now - mFastPollingEnd) >= 0))
+        mFastPolling = false;
+    // Changes are coalesced, only the latest status is written once per save interval
+    if (mStatusSavePending && ((now - mLastStatusSave) > mStatusSaveInterval))
+        saveStatus(now);
     switch (mPhase)
     {
+        case psWarmingUp:
+            if ((now - mSetupTimestamp) > mWarmUpTime)
+            {
+                mPhase = psSendingFirstStatusRequest;
+                return;
+            }
+            break;
         case psSendingFirstStatusRequest:
-        case psSendingStatusRequest:
-            sendData((uint8_t*)&poll_command, poll_command.msg_length, false);
-            mLastStatusRequest = now;
-            mPhase = (ProtocolPhases)((uint8_t)mPhase + 1);
-            mLastRequestTimestamp = now;
+            if (!isLineFree(now))
+                break;
+            sendStatusRequest(now);
+            mPhase = psWaitingFirstStatusAnswer;
             return;
         case psWaitingFirstStatusAnswer:
-            // Using status request interval here to avoid pushing to many messages if AC is not ready
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastRequestTimestamp).count() > STATUS_REQUEST_INTERVAL_MS)
+            // Retry interval grows to avoid pushing to many messages if AC is not ready
+            if ((now - mLastRequestTimestamp) > mFirstStatusRetryInterval)
             {
                 // No valid communication yet, resetting protocol,
                 // No logs to avoid to many messages
-                currentPacket.Reset();
+                resetDecoder();
+                mFirstStatusRetryInterval *= 2;
+                if (mFirstStatusRetryInterval > FIRST_STATUS_RETRY_MAX_MS)
+                    mFirstStatusRetryInterval = FIRST_STATUS_RETRY_MAX_MS;
                 mPhase = psSendingFirstStatusRequest;
                 return;
             }
             break;
         case psWaitingStatusAnswer:
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastRequestTimestamp).count() > ANSWER_TIMOUT_MS)
+        case psWaitingControlAnswer:
+            if ((now - mLastRequestTimestamp) > mAnswerTimeout)
             {
                 // We have valid communication here, no problem if we missed packet or two
                 // Just request packet again in next loop call. We also protected by protocol timeout
                 ESP_LOGW(TAG, "Request answer timeout, phase %d", mPhase);
+                mProtocolStatistics.answerTimeouts++;
+                if (mPhase == psWaitingControlAnswer)
+                    retryControl();
                 mPhase = psIdle;
+                registerFailure(now);
                 return;
             }
             break;
         case psIdle:
-            if (mForceSendControl)
-            {
-                sendControlPacket();
-                mForceSendControl = false;
-            }
+            // Outgoing messages are sent after reading the port, see sendNextMessage()
             break;
         default:
             // Shouldn't get here
             ESP_LOGE(TAG, "Wrong protocol handler state: %d, resetting communication", mPhase);
-            currentPacket.Reset();
+            mProtocolStatistics.protocolResets++;
+            resetDecoder();
             mPhase = psSendingFirstStatusRequest;
             return;
     }
     // Here we expect some input from AC or just waiting for the proper time to send the request
     // Anyway we read the port to make sure that the buffer does not overflow
-    if ((currentPacket.size > 0) && (std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastByteTimestamp).count() > PACKET_TIMOUT_MS))
+#ifndef HAIER_RX_TASK
+    // With RX task packet timeout is handled by the task
+    if (mDecoder.isReceiving() && ((now - mLastByteTimestamp) > mPacketTimeout))
     {
-        ESP_LOGW(TAG, "Incoming packet timeout, packet size %d, expected size %d", currentPacket.position, currentPacket.size);
-        currentPacket.Reset();
+        ESP_LOGW(TAG, "Incoming packet timeout, packet size %d, expected size %d", mDecoder.getPosition(), mDecoder.getExpectedSize());
+        mProtocolStatistics.packetTimeouts++;
+        mDecoder.dropFrame();
     }
+#endif
     getSerialData();
+    logDecoderErrors();
+    uint32_t frameErrors = getFrameErrors();
+    if (frameErrors != mLastFrameErrors)
+    {
+        mLastFrameErrors = frameErrors;
+        registerFailure(now);
+    }
     if (mPhase == psIdle)
+        sendNextMessage(now);
+}
+
+bool HaierClimate::isLineFree(uint32_t now) const
+{
+    // Half-duplex line, wait for the end of our frame, expected answer or incoming frame
+    return ((int32_t)(now - mLineFreeTimestamp) >= 0) && !isReceiving();
+}
+
+bool HaierClimate::isReceiving() const
+{
+#ifdef HAIER_RX_TASK
+    return mRxReceiving.load(std::memory_order_acquire);
+#else
+    return mDecoder.isReceiving();
+#endif
+}
+
+bool HaierClimate::hasInput()
+{
+#ifdef HAIER_RX_TASK
+    return !mRxQueue.empty();
+#else
+    return available() > 0;
+#endif
+}
+
+void HaierClimate::resetDecoder()
+{
+#ifdef HAIER_RX_TASK
+    // Decoder belongs to RX task
+    mRxResetRequest.store(true, std::memory_order_release);
+#else
+    mDecoder.reset();
+#endif
+}
+
+HaierClimate::OutboundMessages HaierClimate::getDueMessage(uint32_t now) const
+{
+    // Control has priority over everything else
+    if (mControlPending)
+        return omControl;
+    // Poll faster for a while after control or state change so the state converges quickly
+    uint32_t interval = (mFastPolling && ((int32_t)(now - mFastPollingEnd) < 0)) ? mFastStatusRequestInterval : mStatusRequestInterval;
+    if ((now - mLastStatusRequest) > interval)
+        return omStatusRequest;
+    if (mSendWifiSignal && ((now - mLastSignalRequest) > SIGNAL_LEVEL_UPDATE_INTERVAL_MS))
+        return omSignalLevel;
+    return omCount;
+}
+
+void HaierClimate::sendNextMessage(uint32_t now)
+{
+    // Called only in idle phase, so no answer is pending
+    if (!isLineFree(now))
+        return;
+    switch (getDueMessage(now))
     {
-        // If we not waiting for answers check if there is a proper time to request data
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - mLastStatusRequest).count() > STATUS_REQUEST_INTERVAL_MS)
-            mPhase = psSendingStatusRequest;
+        case omControl:
+            if (sendControlPacket())
+            {
+                mProtocolStatistics.txFrames[omControl]++;
+                mPhase = psWaitingControlAnswer;
+                mLastRequestTimestamp = now;
+            }
+            break;
+        case omStatusRequest:
+            sendStatusRequest(now);
+            mPhase = psWaitingStatusAnswer;
+            break;
+        case omSignalLevel:
+            sendSignalLevel(now);
+            break;
+        default:
+            break;
     }
 }
 
-void HaierClimate::getSerialData()
+void HaierClimate::sendStatusRequest(uint32_t now)
+{
+    uint8_t frame[HaierProtocol::MAX_FRAME_SIZE];
+    uint8_t size = HaierProtocol::encodeStatusRequest(frame + FRAME_PREFIX_SIZE);
+    sendFrame(frame, size, HaierProtocol::USE_CRC);
+    mProtocolStatistics.txFrames[omStatusRequest]++;
+    mLastStatusRequest = now;
+    mLastRequestTimestamp = now;
+}
+
+void HaierClimate::sendSignalLevel(uint32_t now)
 {
-    while (available() > 0)
+    uint8_t frame[HaierProtocol::SIGNAL_PACKET_SIZE + FRAME_OVERHEAD];
+    uint8_t* message = frame + FRAME_PREFIX_SIZE;
+    bool connected = wifi::global_wifi_component->is_connected();
+    HaierProtocol::encodeSignalReport(message, connected, connected ? wifi::global_wifi_component->wifi_rssi() : 0);
+    sendFrame(frame, HaierProtocol::SIGNAL_PACKET_SIZE, HaierProtocol::USE_CRC);
+    mProtocolStatistics.txFrames[omSignalLevel]++;
+    mLastSignalRequest = now;
+    // AC doesn't have to answer, but give it a chance before sending anything else
+    setLater(mLineFreeTimestamp, now + SIGNAL_ANSWER_WINDOW_MS);
+}
+
+#ifdef HAIER_RX_TASK
+void HaierClimate::rxTask(void* parameter)
+{
+    HaierClimate* climate = (HaierClimate*) parameter;
+    // UART component doesn't provide RX events, so the port is polled every tick
+    while (true)
     {
-        uint8_t val;
-        if (!read_byte(&val))
+        climate->receiveData();
+        vTaskDelay(1);
+    }
+}
+
+void HaierClimate::receiveData()
+{
+    // Decoder, rxBytes and packetTimeouts are used only by this task,
+    // decoder error counters are read by loop() for metrics only
+    if (mRxResetRequest.exchange(false, std::memory_order_acquire))
+        mDecoder.reset();
+    size_t pending = available();
+    mProtocolStatistics.rxBytes += pending;
+    while (pending > 0)
+    {
+        size_t freeSpace;
+        uint8_t* buffer = mDecoder.getWriteBuffer(freeSpace);
+        size_t count = pending < freeSpace ? pending : freeSpace;
+        if ((count == 0) || !read_array(buffer, count))
             break;
-        if (currentPacket.size > 0) // Already found packet start
+        mDecoder.commitWrite(count);
+        pending -= count;
+        queueFrames();
+    }
+    if (mDecoder.isReceiving() && ((mClock() - mLastByteTimestamp) > mPacketTimeout))
+    {
+        mProtocolStatistics.packetTimeouts++;
+        mDecoder.dropFrame();
+        queueFrames();
+    }
+    mRxReceiving.store(mDecoder.isReceiving(), std::memory_order_release);
+}
+
+void HaierClimate::queueFrames()
+{
+    const uint8_t* frame;
+    uint8_t frameSize;
+    HaierFrameDecoder::DecoderEvents event;
+    while ((event = mDecoder.nextEvent(frame, frameSize)) != HaierFrameDecoder::deNone)
+    {
+        if (event == HaierFrameDecoder::deFrameStarted)
+            mLastByteTimestamp = mClock();
+        else if (!mRxQueue.push(frame, frameSize))
+            mProtocolStatistics.rxQueueOverflows++;
+    }
+}
+
+void HaierClimate::getSerialData()
+{
+    uint32_t start = micros();
+    // publish_state() is called from here but its time is counted separately
+    uint32_t publishingTime = mProtocolStatistics.publishingTime;
+    const uint8_t* frame;
+    uint8_t frameSize;
+    while ((frame = mRxQueue.front(frameSize)) != NULL)
+    {
+#ifdef HAIER_CAPTURE_SIZE
+        // Only complete frames are visible here, without 0xFF 0xFF
+        mCapture.record(HaierCapture::cdReceived, mClock(), frame, frameSize);
+#endif
+        mProtocolStatistics.rxFrames++;
+        setLater(mLineFreeTimestamp, mClock() + mFrameGap);
+        handleIncomingPacket(frame, frameSize);
+        mRxQueue.pop();
+    }
+    mProtocolStatistics.rxProcessingTime += (micros() - start) - (mProtocolStatistics.publishingTime - publishingTime);
+}
+#else
+void HaierClimate::processFrames()
+{
+    // Frames point into decoder buffer so they should be handled before next read
+    const uint8_t* frame;
+    uint8_t frameSize;
+    HaierFrameDecoder::DecoderEvents event;
+    while ((event = mDecoder.nextEvent(frame, frameSize)) != HaierFrameDecoder::deNone)
+    {
+        if (event == HaierFrameDecoder::deFrameStarted)
+            mLastByteTimestamp = mClock();   // Using timeout to make sure we not stuck
+        else
         {
-            if (currentPacket.position < currentPacket.size)
-            {
-                currentPacket.buffer[currentPacket.position++] = val;
-                if (currentPacket.position < currentPacket.size)
-                    currentPacket.checksum += val;
-            }
-            if (currentPacket.position >= currentPacket.size)
-            {
-                bool isValid = true;
-                if (currentPacket.checksum != currentPacket.buffer[currentPacket.size - 1])
-                {
-                    ESP_LOGW(TAG, "Wrong packet checksum: 0x%02X (expected 0x%02X)", currentPacket.checksum, currentPacket.buffer[currentPacket.size - 1]);
-                    isValid = false;
-                }
-                if (isValid)
-                {
-                    // We got valid packet here, need to handle it
-                    handleIncomingPacket();
-               }
-                currentPacket.Reset();
-            }
+            mProtocolStatistics.rxFrames++;
+            setLater(mLineFreeTimestamp, mClock() + mFrameGap);
+            handleIncomingPacket(frame, frameSize);
         }
-        else // Haven't found beginning of packet yet
+    }
+}
+
+void HaierClimate::getSerialData()
+{
+    uint32_t start = micros();
+    // publish_state() is called from here but its time is counted separately
+    uint32_t publishingTime = mProtocolStatistics.publishingTime;
+    // Data left after dropped frame can contain next frame
+    processFrames();
+    // Work in one loop() call is limited, the rest of input is left in UART buffer for the next call
+    bool overloaded = false;
+    size_t pending = available();
+    if (pending > mRxByteBudget)
+    {
+        pending = mRxByteBudget;
+        overloaded = true;
+    }
+    while (pending > 0)
+    {
+        size_t freeSpace;
+        uint8_t* buffer = mDecoder.getWriteBuffer(freeSpace);
+        size_t count = pending < freeSpace ? pending : freeSpace;
+        if ((count == 0) || !read_array(buffer, count))
+            break;
+        mDecoder.commitWrite(count);
+        mProtocolStatistics.rxBytes += count;
+#ifdef HAIER_CAPTURE_SIZE
+        mCapture.record(HaierCapture::cdReceived, mClock(), buffer, count);
+#endif
+        pending -= count;
+        processFrames();
+        if ((pending > 0) && ((micros() - start) > mRxTimeBudget))
         {
-            if (val == HEADER)
-                currentPacket.preHeaderCharsCounter++;
-            else
-            {
-                if (currentPacket.preHeaderCharsCounter >= 2)
-                {
-                    if ((val + 3 <= MAX_MESSAGE_SIZE) and (val >= 8)) // Packet size should be at least 8
-                    {
-                        // Valid packet size
-                        currentPacket.size = val + 1;    // Space for checksum
-                        currentPacket.buffer[0] = val;
-                        currentPacket.checksum += val;  // will calculate checksum on the fly
-                        currentPacket.position = 1;
-                        mLastByteTimestamp = std::chrono::steady_clock::now();   // Using timeout to make sure we not stuck
-                    }
-                    else
-                        ESP_LOGW(TAG, "Wrong packet size %d", val);
-                }
-                currentPacket.preHeaderCharsCounter = 0;
-            }
+            overloaded = true;
+            break;
         }
     }
+    if (overloaded)
+        mProtocolStatistics.rxOverloads++;
+    mProtocolStatistics.rxProcessingTime += (micros() - start) - (mProtocolStatistics.publishingTime - publishingTime);
 }
+#endif
 
-void HaierClimate::handleIncomingPacket()
+void HaierClimate::handleIncomingPacket(const uint8_t* packet, uint8_t size)
 {
-    HaierPacketHeader& header = (HaierPacketHeader&)currentPacket.buffer;
-    std::string packet_type;
+    HaierProtocol::AnswerTypes answerType = HaierProtocol::getAnswerType(packet);
+    const char* packet_type;
     ProtocolPhases oldPhase = mPhase;
     int level = ESPHOME_LOG_LEVEL_DEBUG;
-    bool wrongPhase = false;
-    switch (header.msg_type)
+    bool repeatedStatus = false;
+    uint32_t now = mClock();
+    if (((mPhase == psWaitingFirstStatusAnswer) || (mPhase == psWaitingStatusAnswer) || (mPhase == psWaitingControlAnswer)) &&
+        ((answerType == HaierProtocol::atStatus) || (answerType == HaierProtocol::atError)))
+        recordAnswerTime(now);
+    if (mPhase == psWarmingUp)
+    {
+        // AC is already sending valid frames, no need to wait more
+        ESP_LOGI(TAG, "AC is ready, skipping warm up");
+        mPhase = psSendingFirstStatusRequest;
+    }
+    switch (answerType)
     {
-        case hpAnswerRequestStatus:
+        case HaierProtocol::atStatus:
             packet_type = "Poll command answer";
             if (mPhase >= psWaitingFirstStatusAnswer) // Accept status on any stage after initialization
             {
-                if (mPhase == psWaitingFirstStatusAnswer)
-                    ESP_LOGI(TAG, "First status received");
+                bool firstStatus = mPhase == psWaitingFirstStatusAnswer;
+                registerRecovery(now);
+                if (firstStatus && (mProtocolStatistics.firstStatusTime == 0))
                 {
-                    Lock _lock(mReadMutex);
-                    memcpy(mLastPacket, currentPacket.buffer, currentPacket.size);
+                    mProtocolStatistics.firstStatusTime = now - mSetupTimestamp;
+                    ESP_LOGI(TAG, "First status received in %u ms after setup", mProtocolStatistics.firstStatusTime);
                 }
-                processStatus(currentPacket.buffer, currentPacket.size);
-                if ((mPhase == psWaitingStatusAnswer) || (mPhase == psWaitingFirstStatusAnswer))
+                // Only control bytes matter, no need to decode the same state again
+                uint8_t lastControl[HaierProtocol::CONTROL_PACKET_SIZE - HaierProtocol::HEADER_SIZE];
+                repeatedStatus = !firstStatus && (size >= HaierProtocol::CONTROL_PACKET_SIZE) &&
+                    mLastStatus.read(lastControl, HaierProtocol::HEADER_SIZE, sizeof(lastControl)) &&
+                    (memcmp(lastControl, packet + HaierProtocol::HEADER_SIZE, sizeof(lastControl)) == 0);
+                mLastStatus.write(packet, size);
+                if (mRestoreStatus && !repeatedStatus)
+                    mStatusSavePending = true;
+                mLastValidStatusTimestamp = now;
+                if (!repeatedStatus && !firstStatus)
+                    startFastPolling();
+                if (mPhase == psWaitingControlAnswer)
+                {
+                    // Status answer is acknowledgement of control packet
+                    if (size < HaierProtocol::CONTROL_PACKET_SIZE)
+                        retryControl();
+                    else
+                        checkControlAnswer(packet);
+                }
+                // Keep optimistic state until control request is finished
+                bool optimisticHold = mOptimisticPending && mControlPending;
+                if (!optimisticHold && (!repeatedStatus || mOptimisticPending || ((now - mLastPublishTimestamp) > mMaxPublishSilence)))
+                {
+                    processStatus(packet, size);
+                    mLastPublishTimestamp = now;
+                    mPublishStatistics.published++;
+                    if (mOptimisticPending)
+                        reconcileOptimisticState(now);
+                }
+                else if (optimisticHold)
+                    mPublishStatistics.held++;
+                else
+                    mPublishStatistics.suppressed++;
+                if ((mPhase == psWaitingStatusAnswer) || (mPhase == psWaitingFirstStatusAnswer) || (mPhase == psWaitingControlAnswer))
                     // Change phase only if we were waiting for status
                     mPhase = psIdle;
             }
             else
                 level = ESPHOME_LOG_LEVEL_WARN;
             break;
-        case hpAnswerError:
+        case HaierProtocol::atError:
             packet_type = "Command error";
             level = ESPHOME_LOG_LEVEL_WARN;
-            if (mPhase == psWaitingStatusAnswer)
+            if (mPhase == psWaitingControlAnswer)
+                retryControl();
+            if ((mPhase == psWaitingStatusAnswer) || (mPhase == psWaitingControlAnswer))
                 mPhase = psIdle;
             // No else to avoid to many requests, we will retry on timeout
             break;
+        case HaierProtocol::atConfirm:
+            packet_type = "Confirmation";
+            // Signal report confirmed, no need to wait till the end of answer window
+            mLineFreeTimestamp = now + mFrameGap;
+            break;
         default:
             packet_type = "Unknown";
             break;
     }
-    std::string raw = getHex(currentPacket.buffer, currentPacket.size);
-    ESP_LOG_L(level, TAG, "Received %s message during phase %d, size: %d, content: %02X %02X%s", packet_type.c_str(), oldPhase, currentPacket.size, HEADER, HEADER, raw.c_str());
+    // Log identical status answers only once per STATUS_LOG_REPEAT_INTERVAL
+    bool suppressed = false;
+    if (repeatedStatus)
+    {
+        if (++mRepeatedStatusCounter < STATUS_LOG_REPEAT_INTERVAL)
+            suppressed = true;
+        else
+            mRepeatedStatusCounter = 0;
+    }
+    else
+        mRepeatedStatusCounter = 0;
+    if (!suppressed && isLogLevelEnabled(level))
+    {
+        char raw[HEX_BUFFER_SIZE];
+        mLogStatistics.bytesFormatted += getHex(raw, sizeof(raw), packet, size);
+        ESP_LOG_L(level, TAG, "Received %s message during phase %d, size: %d, content: %02X %02X%s", packet_type, oldPhase, size, HaierProtocol::FRAME_HEADER, HaierProtocol::FRAME_HEADER, raw);
+    }
+    else
+        mLogStatistics.bytesSuppressed += size;
 }
 
 void HaierClimate::sendData(const uint8_t * message, size_t size, bool withCrc)
 {
-    uint8_t packetSize = size + (withCrc ? 5 : 3);
-    if (packetSize > MAX_MESSAGE_SIZE)
+    if (size + FRAME_OVERHEAD > HaierProtocol::MAX_FRAME_SIZE)
     {
-        ESP_LOGE(TAG, "Message is to big: %d", size);
+        ESP_LOGE(TAG, "Message is to big: %u", (unsigned)size);
         return;
     }
-    uint8_t buffer[MAX_MESSAGE_SIZE] = {0xFF, 0xFF};
-    memcpy(buffer + 2, message, size);
+    uint8_t buffer[HaierProtocol::MAX_FRAME_SIZE];
+    memcpy(buffer + FRAME_PREFIX_SIZE, message, size);
+    sendFrame(buffer, size, withCrc);
+}
+
+void HaierClimate::sendFrame(uint8_t* buffer, size_t size, bool withCrc)
+{
+    // Message is already in place, only start of packet indication and checksums are added
+    uint8_t packetSize = size + (withCrc ? 5 : 3);
+    buffer[0] = HaierProtocol::FRAME_HEADER;
+    buffer[1] = HaierProtocol::FRAME_HEADER;
     buffer[size + 2] = getChecksum(buffer + 2, size);
     if (withCrc)
     {
@@ -385,204 +1176,214 @@ void HaierClimate::sendData(const uint8_t * message, size_t size, bool withCrc)
         buffer[size + 4] = crc_16 & 0xFF;
     }
     write_array(buffer, packetSize);
-    ESP_LOGD(TAG, "Message sent:%s", getHex(buffer, packetSize).c_str());
+    mProtocolStatistics.txBytes += packetSize;
+    // Frame is still being transmitted after write_array() returns
+    setLater(mLineFreeTimestamp, mClock() + (packetSize * BYTE_TRANSFER_TIME_US) / 1000 + 1 + mFrameGap);
+#ifdef HAIER_CAPTURE_SIZE
+    mCapture.record(HaierCapture::cdSent, mClock(), buffer, packetSize);
+#endif
+    if (isLogLevelEnabled(ESPHOME_LOG_LEVEL_DEBUG))
+    {
+        char raw[HEX_BUFFER_SIZE];
+        mLogStatistics.bytesFormatted += getHex(raw, sizeof(raw), buffer, packetSize);
+        ESP_LOGD(TAG, "Message sent:%s", raw);
+    }
+    else
+        mLogStatistics.bytesSuppressed += packetSize;
+}
+
+namespace
+{
+    climate::ClimateTraits buildTraits()
+    {
+        climate::ClimateTraits traits;
+        traits.set_supported_modes(
+        {
+            climate::CLIMATE_MODE_OFF,
+            climate::CLIMATE_MODE_COOL,
+            climate::CLIMATE_MODE_HEAT,
+            climate::CLIMATE_MODE_FAN_ONLY,
+            climate::CLIMATE_MODE_DRY,
+            climate::CLIMATE_MODE_AUTO
+        });
+        traits.set_supported_fan_modes(
+        {
+            climate::CLIMATE_FAN_AUTO,
+            climate::CLIMATE_FAN_LOW,
+            climate::CLIMATE_FAN_MEDIUM,
+            climate::CLIMATE_FAN_HIGH,
+        });
+        traits.set_supported_swing_modes(
+        {
+            climate::CLIMATE_SWING_OFF,
+            climate::CLIMATE_SWING_BOTH,
+            climate::CLIMATE_SWING_VERTICAL,
+            climate::CLIMATE_SWING_HORIZONTAL
+        });
+        traits.set_visual_min_temperature(MIN_SET_TEMPERATURE);
+        traits.set_visual_max_temperature(MAX_SET_TEMPERATURE);
+        traits.set_visual_temperature_step(1.0f);
+        traits.set_supports_current_temperature(true);
+        return traits;
+    }
 }
 
 ClimateTraits HaierClimate::traits()
 {
-    return mTraits;
+    // Traits are the same for all instances, built once on first call.
+    // Climate interface requires a copy to be returned
+    static const ClimateTraits traits = buildTraits();
+    return traits;
 }
 
-void HaierClimate::sendControlPacket(const ClimateCall* climateControl)
+bool HaierClimate::sendControlPacket()
 {
-    if(mPhase <= psWaitingFirstStatusAnswer)
+    // Control packet is encoded in place in the outgoing frame, starting with the last known state
+    uint8_t frame[HaierProtocol::CONTROL_PACKET_SIZE + FRAME_OVERHEAD];
+    uint8_t* message = frame + FRAME_PREFIX_SIZE;
+    if (!mLastStatus.read(message + HaierProtocol::HEADER_SIZE, HaierProtocol::HEADER_SIZE, HaierProtocol::CONTROL_PACKET_SIZE - HaierProtocol::HEADER_SIZE))
     {
-        ESP_LOGE(TAG, "sendControlPacket: Can't send control packet, first poll answer not received");
-        return; //cancel the control, we cant do it without a poll answer.
+        ESP_LOGE("Control", "Can't send control packet, no valid status received");
+        clearControlRequest();
+        return false;
     }
-    uint8_t controlOutBuffer[CONTROL_PACKET_SIZE];
-    memcpy(controlOutBuffer, &control_command, HEADER_SIZE);
+    switch (HaierProtocol::encodeControl(message, mControlRequest, mDisplayStatus, mControlContext))
     {
-        Lock _lock(mReadMutex);
-        memcpy(&controlOutBuffer[HEADER_SIZE], &mLastPacket[HEADER_SIZE], CONTROL_PACKET_SIZE - HEADER_SIZE);
+        case HaierProtocol::ceUnsupportedMode:
+            ESP_LOGE("Control", "Unsupported climate mode");
+            clearControlRequest();
+            return false;
+        case HaierProtocol::ceUnsupportedFanMode:
+            ESP_LOGE("Control", "Unsupported fan mode");
+            clearControlRequest();
+            return false;
+        case HaierProtocol::ceUnchanged:
+            // Nothing to do if AC is already in requested state
+            ESP_LOGD("Control", "AC is already in requested state");
+            clearControlRequest();
+            return false;
+        default:
+            break;
     }
-    HaierControl& outData = (HaierControl&) controlOutBuffer;
-    outData.control.cntrl = 0;
-    if (climateControl != NULL)
+    mControlRequestChanged = false;
+    memcpy(mSentControl, message, HaierProtocol::CONTROL_PACKET_SIZE);
+    sendFrame(frame, HaierProtocol::CONTROL_PACKET_SIZE, HaierProtocol::USE_CRC);
+    return true;
+}
+
+void HaierClimate::checkControlAnswer(const uint8_t* answer)
+{
+    bool applied = HaierProtocol::matchesControl(answer, mSentControl);
+    if (!applied)
+        retryControl();
+    else if (!mControlRequestChanged)
+        // Nothing new was requested while waiting for the answer
+        clearControlRequest();
+}
+
+void HaierClimate::retryControl()
+{
+    if (mControlRetries < CONTROL_RETRIES)
     {
-        if (climateControl->get_mode().has_value())
-        {
-            switch (*climateControl->get_mode())
-            {
-                case CLIMATE_MODE_OFF:
-                    outData.control.ac_power = 0;
-                    break;
-
-                case CLIMATE_MODE_AUTO:
-                    outData.control.ac_power = 1;
-                    outData.control.ac_mode = ConditioningAuto;
-                    outData.control.fan_mode = mOtherModesFanSpeed;
-                    break;
-
-                case CLIMATE_MODE_HEAT:
-                    outData.control.ac_power = 1;
-                    outData.control.ac_mode = ConditioningHeat;
-                    outData.control.fan_mode = mOtherModesFanSpeed;
-                    break;
-
-                case CLIMATE_MODE_DRY:
-                    outData.control.ac_power = 1;
-                    outData.control.ac_mode = ConditioningDry;
-                    outData.control.fan_mode = mOtherModesFanSpeed;
-                    break;
-
-                case CLIMATE_MODE_FAN_ONLY:
-                    outData.control.ac_power = 1;
-                    outData.control.ac_mode = ConditioningFan;
-                    outData.control.fan_mode = mFanModeFanSpeed;    // Auto doesn't work in fan only mode
-                    break;
-
-                case CLIMATE_MODE_COOL:
-                    outData.control.ac_power = 1;
-                    outData.control.ac_mode = ConditioningCool;
-                    outData.control.fan_mode = mOtherModesFanSpeed;
-                    break;
-                default:
-                    ESP_LOGE("Control", "Unsupported climate mode");
-                    return;
-            }
-        }
-        //Set fan speed, if we are in fan mode, reject auto in fan mode
-        if (climateControl->get_fan_mode().has_value())
-        {
-            switch(climateControl->get_fan_mode().value())
-            {
-                case CLIMATE_FAN_LOW:
-                    outData.control.fan_mode = FanLow;
-                    break;
-                case CLIMATE_FAN_MEDIUM:
-                    outData.control.fan_mode = FanMid;
-                    break;
-                case CLIMATE_FAN_HIGH:
-                    outData.control.fan_mode = FanHigh;
-                    break;
-                case CLIMATE_FAN_AUTO:
-                    if (mode != CLIMATE_MODE_FAN_ONLY) //if we are not in fan only mode
-                        outData.control.fan_mode = FanAuto;
-                    break;
-                default:
-                    ESP_LOGE("Control", "Unsupported fan mode");
-                    return;
-            }
-        }
-        //Set swing mode
-        if (climateControl->get_swing_mode().has_value())
-        {
-            switch(climateControl->get_swing_mode().value())
-            {
-                case CLIMATE_SWING_OFF:
-                    outData.control.use_swing_bits = 0;
-                    outData.control.swing_both = 0;
-                    break;
-                case CLIMATE_SWING_VERTICAL:
-                    outData.control.swing_both = 0;
-                    outData.control.vertical_swing = 1;
-                    outData.control.horizontal_swing = 0;
-                    break;
-                case CLIMATE_SWING_HORIZONTAL:
-                    outData.control.swing_both = 0;
-                    outData.control.vertical_swing = 0;
-                    outData.control.horizontal_swing = 1;
-                    break;
-                case CLIMATE_SWING_BOTH:
-                    outData.control.swing_both = 1;
-                    outData.control.use_swing_bits = 0;
-                    outData.control.vertical_swing = 0;
-                    outData.control.horizontal_swing = 0;
-                    break;
-            }
-        }
-        if (climateControl->get_target_temperature().has_value())
-            outData.control.set_point = *climateControl->get_target_temperature() - 16; //set the temperature at our offset, subtract 16.
+        mControlRetries++;
+        ESP_LOGW("Control", "Control packet was not applied, retry %d", mControlRetries);
     }
-    outData.control.display_off = mDisplayStatus ? 0 : 1;   
-    sendData(controlOutBuffer, controlOutBuffer[0], false);
+    else
+    {
+        ESP_LOGE("Control", "Control packet was not applied after %d retries", CONTROL_RETRIES);
+        clearControlRequest();
+    }
+}
+
+void HaierClimate::clearControlRequest()
+{
+    mControlRequest = HaierControlRequest();
+    mControlPending = false;
+    mControlRequestChanged = false;
+    mControlRetries = 0;
 }
 
 void HaierClimate::control(const ClimateCall &call)
 {
-    static uint8_t controlOutBuffer[CONTROL_PACKET_SIZE];
     ESP_LOGD("Control", "Control call");
-    sendControlPacket(&call);
+    // Merge with not sent yet requests, control packet is sent when protocol is idle
+    if (call.get_mode().has_value())
+        mControlRequest.mode = call.get_mode();
+    if (call.get_fan_mode().has_value())
+        mControlRequest.fanMode = call.get_fan_mode();
+    if (call.get_swing_mode().has_value())
+        mControlRequest.swingMode = call.get_swing_mode();
+    if (call.get_target_temperature().has_value())
+        mControlRequest.targetTemperature = call.get_target_temperature();
+    mControlPending = true;
+    mControlRequestChanged = true;
+    mControlRetries = 0;
+    startFastPolling();
+    if (mOptimistic)
+    {
+        // Show requested state right away, it will be checked against next status
+        if (call.get_mode().has_value())
+            mode = *call.get_mode();
+        if (call.get_fan_mode().has_value())
+            fan_mode = call.get_fan_mode();
+        if (call.get_swing_mode().has_value())
+            swing_mode = *call.get_swing_mode();
+        if (call.get_target_temperature().has_value())
+            target_temperature = *call.get_target_temperature();
+        if (!mOptimisticPending)
+            mOptimisticTimestamp = mClock();
+        mOptimisticPending = true;
+        mOptimisticRequest = mControlRequest;
+        this->publish_state();
+    }
 }
 
-void HaierClimate::processStatus(const uint8_t* packetBuffer, uint8_t size)
+void HaierClimate::reconcileOptimisticState(uint32_t now)
 {
-    HaierStatus* packet = (HaierStatus*) packetBuffer;
-    ESP_LOGD(TAG, "HVAC Mode = 0x%X", packet->control.ac_mode);
-    ESP_LOGD(TAG, "Fan speed Status = 0x%X", packet->control.fan_mode);
-    ESP_LOGD(TAG, "Set Point Status = 0x%X", packet->control.set_point);
-    target_temperature = packet->control.set_point + 16;
-    current_temperature = packet->control.room_temperature;
-    //remember the fan speed we last had for climate vs fan
-    if (packet->control.ac_mode ==  ConditioningFan)
-        mFanModeFanSpeed = packet->control.fan_mode;
-    else
-        mOtherModesFanSpeed = packet->control.fan_mode;
-    switch (packet->control.fan_mode)
-    {
-                case FanAuto:
-                    fan_mode = CLIMATE_FAN_AUTO;
-                    break;
-                case FanMid:
-                    fan_mode = CLIMATE_FAN_MEDIUM;
-                    break;
-                case FanLow:
-                    fan_mode = CLIMATE_FAN_LOW;
-                    break;
-                case FanHigh:
-                    fan_mode = CLIMATE_FAN_HIGH;
-                    break;
-    }
-    //climate mode
-    if (packet->control.ac_power == 0)
-        mode = CLIMATE_MODE_OFF;
-    else
+    mOptimisticPending = false;
+    uint32_t latency = now - mOptimisticTimestamp;
+    mOptimisticStatistics.lastLatency = latency;
+    if (latency > mOptimisticStatistics.maxLatency)
+        mOptimisticStatistics.maxLatency = latency;
+    bool confirmed = true;
+    if (mOptimisticRequest.mode.has_value() && (*mOptimisticRequest.mode != mode))
+        confirmed = false;
+    if (mOptimisticRequest.fanMode.has_value() && (mOptimisticRequest.fanMode != fan_mode))
+        confirmed = false;
+    if (mOptimisticRequest.swingMode.has_value() && (*mOptimisticRequest.swingMode != swing_mode))
+        confirmed = false;
+    if (mOptimisticRequest.targetTemperature.has_value() && ((int)*mOptimisticRequest.targetTemperature != (int)target_temperature))
+        confirmed = false;
+    if (confirmed)
     {
-        // Check current hvac mode
-        switch (packet->control.ac_mode)
-        {
-            case ConditioningCool:
-                mode = CLIMATE_MODE_COOL;
-                break;
-            case ConditioningHeat:
-                mode = CLIMATE_MODE_HEAT;
-                break;
-            case ConditioningDry:
-                mode = CLIMATE_MODE_DRY;
-                break;
-            case ConditioningFan:
-                mode = CLIMATE_MODE_FAN_ONLY;
-                break;
-            case ConditioningAuto:
-                 mode = CLIMATE_MODE_AUTO;
-                 break;
-        }
+        mOptimisticStatistics.confirmed++;
+        ESP_LOGD("Control", "Optimistic state confirmed in %u ms", latency);
     }
-    // Swing mode
-    if (packet->control.swing_both == 0)
+    else
     {
-        if (packet->control.vertical_swing != 0)
-            swing_mode = CLIMATE_SWING_VERTICAL;
-        else if (packet->control.horizontal_swing != 0)
-            swing_mode = CLIMATE_SWING_HORIZONTAL;
-        else
-            swing_mode = CLIMATE_SWING_OFF;
+        // Actual state is already published by processStatus
+        mOptimisticStatistics.rolledBack++;
+        ESP_LOGW("Control", "AC didn't accept requested state, rolled back after %u ms", latency);
     }
-    else
-        swing_mode = CLIMATE_SWING_BOTH;
-    mLastValidStatusTimestamp = std::chrono::steady_clock::now();
+    mOptimisticRequest = HaierControlRequest();
+}
+
+void HaierClimate::processStatus(const uint8_t* packetBuffer, uint8_t size)
+{
+    uint32_t start = micros();
+    HaierClimateState state = { mode, fan_mode, swing_mode, target_temperature, current_temperature };
+    HaierProtocol::decodeStatus(packetBuffer, state, mControlContext);
+    mode = state.mode;
+    fan_mode = state.fanMode;
+    swing_mode = state.swingMode;
+    target_temperature = state.targetTemperature;
+    current_temperature = state.currentTemperature;
+    ESP_LOGD(TAG, "Status: mode %d, fan mode %d, swing mode %d, set point %.0f", mode,
+             fan_mode.has_value() ? (int)*fan_mode : -1, swing_mode, target_temperature);
+    uint32_t decoded = micros();
+    mProtocolStatistics.decodingTime += decoded - start;
     this->publish_state();
+    mProtocolStatistics.publishingTime += micros() - decoded;
 }
 
 } // namespace haier
@@ -1,26 +1,20 @@
 #ifndef _HAIER_CLIMATE_H
 #define _HAIER_CLIMATE_H
 
-#include <chrono>
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/uart/uart.h"
-
-#if ESP8266
-// No mutexes for ESP8266 just make dummy classes and pray...
-struct Mutex
-{
-    void lock() {};
-    void unlock() {};
-};
-
-struct Lock
-{
-    Lock(const Mutex&) {};
-}; 
-#else
-#include <mutex>
-typedef std::mutex Mutex;
-typedef std::lock_guard<Mutex> Lock;
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/preferences.h"
+#include "haier_protocol.h"
+#include "haier_climate_state.h"
+#include "haier_frame_decoder.h"
+#include "haier_capture.h"
+#include "haier_status_snapshot.h"
+#ifdef HAIER_RX_TASK
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "haier_frame_queue.h"
 #endif
 
 namespace esphome {
@@ -35,44 +29,261 @@ public:
     HaierClimate(const HaierClimate&) = delete;
     HaierClimate& operator=(const HaierClimate&) = delete;
     HaierClimate(esphome::uart::UARTComponent* parent);
-    ~HaierClimate();
     void setup() override;
     void loop() override;
+    // Logs configuration and per-instance RAM footprint
+    void dump_config() override;
     void control(const esphome::climate::ClimateCall &call) override;
     float get_setup_priority() const override { return esphome::setup_priority::HARDWARE ; }
     void set_display_state(bool state);
     bool get_display_state() const;
+    // Copy beginning of last valid status frame (starting from message length byte), safe to call from any task
+    bool get_last_status(uint8_t* buffer, size_t size) const;
+    void set_verify_crc(bool verify);
+    // Unchanged status is published again only after this time
+    void set_max_publish_silence(uint32_t silence_ms);
+    // Time to wait after setup before first request, ends earlier if AC sends valid frames
+    void set_warm_up_time(uint32_t time_ms);
+    void set_packet_timeout(uint32_t timeout_ms);
+    void set_answer_timeout(uint32_t timeout_ms);
+    void set_communication_timeout(uint32_t timeout_ms);
+    // Status is requested with fast interval during fast polling window after control
+    // or state change and with normal interval otherwise
+    void set_status_request_interval(uint32_t interval_ms);
+    void set_fast_status_request_interval(uint32_t interval_ms);
+    void set_fast_polling_window(uint32_t window_ms);
+    // Publish requested state before AC confirms it
+    void set_optimistic(bool optimistic);
+    // Report WiFi signal level to AC periodically
+    void set_send_wifi_signal(bool send);
+    // Minimal pause on the line between end of last frame and next outgoing frame
+    void set_frame_gap(uint32_t gap_ms);
+    // Consecutive answer timeouts or broken frames before protocol is resynchronized
+    void set_recovery_threshold(uint8_t failures);
+    // Limits for reading and handling input in one loop() call, without RX task only
+    void set_rx_byte_budget(uint32_t bytes);
+    void set_rx_time_budget(uint32_t time_us);
+    // Time source for all protocol timing in ms, millis() by default.
+    // Replacing it allows to run timeouts and polling in virtual time
+    typedef uint32_t (*ClockFunction)();
+    void set_clock(ClockFunction clock);
+    // Keep last status in preferences and publish it at boot until AC answers
+    void set_restore_status(bool restore);
+    // Changed status is saved not more often than this interval
+    void set_status_save_interval(uint32_t interval_ms);
+    // Outgoing message types in priority order, only one message is sent when line is free
+    enum OutboundMessages
+    {
+        omControl = 0,
+        omStatusRequest,
+        omSignalLevel,
+        omCount
+    };
+    struct LogStatistics
+    {
+        uint32_t    bytesFormatted;     // Frame bytes rendered into hex dumps
+        uint32_t    bytesSuppressed;    // Frame bytes skipped because of log level or repeated status
+    };
+    const LogStatistics& get_log_statistics() const;
+    const HaierFrameDecoder::Statistics& get_decoder_statistics() const;
+    struct PublishStatistics
+    {
+        uint32_t    published;          // Status answers decoded and published
+        uint32_t    suppressed;         // Status answers skipped because nothing changed
+        uint32_t    held;               // Status answers not published to keep optimistic state until control is finished
+    };
+    const PublishStatistics& get_publish_statistics() const;
+    struct OptimisticStatistics
+    {
+        uint32_t    confirmed;          // Optimistic states confirmed by AC
+        uint32_t    rolledBack;         // Optimistic states replaced by actual AC state
+        uint32_t    lastLatency;        // Time from optimistic publish to AC status, ms
+        uint32_t    maxLatency;
+    };
+    const OptimisticStatistics& get_optimistic_statistics() const;
+    // Answer round-trip time histogram upper bounds in ms, last bucket counts all longer answers
+    static constexpr uint16_t RTT_HISTOGRAM_BOUNDS[] = { 50, 100, 200, 500, 1000 };
+    static constexpr size_t RTT_HISTOGRAM_SIZE = sizeof(RTT_HISTOGRAM_BOUNDS) / sizeof(RTT_HISTOGRAM_BOUNDS[0]) + 1;
+    struct ProtocolStatistics
+    {
+        uint32_t    packetTimeouts;     // Incomplete incoming packets
+        uint32_t    answerTimeouts;
+        uint32_t    protocolResets;     // No valid status for communication timeout
+        uint32_t    firstStatusTime;    // Time from setup to first status, ms
+        uint32_t    answers;            // Answers with measured round-trip time
+        uint32_t    rttTotal;           // Sum of all round-trip times, ms
+        uint32_t    rttHistogram[RTT_HISTOGRAM_SIZE];
+        // Processing cost, time in microseconds
+        uint32_t    rxBytes;
+        uint32_t    rxOverloads;        // loop() calls that left input for the next call because of budget
+        uint32_t    rxQueueOverflows;   // Frames lost because loop() didn't take them from RX task queue in time
+        uint32_t    rxFrames;           // Valid frames
+        uint32_t    rxProcessingTime;   // Reading and handling incoming data including status decoding, without publishing
+        uint32_t    decodingTime;       // Status decoding, see PublishStatistics for number of decoded statuses
+        uint32_t    publishingTime;     // publish_state() calls
+        uint32_t    loopCalls;
+        uint32_t    activeLoopCalls;    // loop() calls that had something to do
+        uint32_t    activeLoopTime;
+        // Outgoing traffic
+        uint32_t    txBytes;
+        uint32_t    txFrames[omCount];  // Sent frames by message type
+        // Recovery
+        uint32_t    resyncs;            // Decoder flushes after consecutive failures
+        uint32_t    recoveries;         // Valid status after one or more failures
+        uint32_t    lastRecoveryTime;   // Time from first failure to valid status, ms
+        uint32_t    maxRecoveryTime;
+    };
+    const ProtocolStatistics& get_protocol_statistics() const;
+    enum MetricSensors
+    {
+        msChecksumErrors = 0,   // Checksum and CRC errors
+        msWrongSizeErrors,
+        msPacketTimeouts,
+        msAnswerTimeouts,
+        msProtocolResets,
+        msRecoveredFrames,
+        msRxOverloads,
+        msAnswerRtt,            // Average answer round-trip time since last update
+        msFrameProcessingTime,  // Average time spent on reading and handling per received frame since last update
+        msBusUtilization,       // Share of time line was busy in both directions since last update, %
+        msRecoveryTime,         // Last time to recover, published only after new recovery
+        msCount
+    };
+    void set_metric_sensor(MetricSensors metric, esphome::sensor::Sensor* sensor);
+    void set_metrics_update_interval(uint32_t interval_ms);
+    // Log content of UART capture buffer (if enabled by capture_buffer_size),
+    // as hex lines per record or compact base64 lines for host/tools/haier_replay
+    void dump_capture(bool binary = false);
+    void clear_capture();
 protected:
     esphome::climate::ClimateTraits traits() override;
     void sendData(const uint8_t * message, size_t size, bool withCrc = true);
+    void sendFrame(uint8_t* buffer, size_t size, bool withCrc);
     void processStatus(const uint8_t* packet, uint8_t size);
-    void handleIncomingPacket();
+    void handleIncomingPacket(const uint8_t* packet, uint8_t size);
+    void processProtocol(uint32_t now);
+    uint32_t getNextDeadline(uint32_t now) const;
     void getSerialData();
-    void sendControlPacket(const esphome::climate::ClimateCall* control = NULL);
+    bool hasInput();
+    bool isReceiving() const;
+    void resetDecoder();
+#ifdef HAIER_RX_TASK
+    static void rxTask(void* parameter);
+    void receiveData();
+    void queueFrames();
+#else
+    void processFrames();
+#endif
+    void startFastPolling();
+    bool isLineFree(uint32_t now) const;
+    OutboundMessages getDueMessage(uint32_t now) const;
+    void sendNextMessage(uint32_t now);
+    void sendStatusRequest(uint32_t now);
+    void sendSignalLevel(uint32_t now);
+    bool sendControlPacket();
+    void checkControlAnswer(const uint8_t* answer);
+    void retryControl();
+    void clearControlRequest();
+    void reconcileOptimisticState(uint32_t now);
+    void recordAnswerTime(uint32_t now);
+    void publishMetrics(uint32_t elapsed);
+    uint32_t getFrameErrors() const;
+    void logDecoderErrors();
+    void registerFailure(uint32_t now);
+    void registerRecovery(uint32_t now);
+    void restoreStatus();
+    void saveStatus(uint32_t now);
 private:
     enum ProtocolPhases
     {
         // Initialization
-        psSendingFirstStatusRequest = 0,
+        psWarmingUp = 0,
+        psSendingFirstStatusRequest,
         psWaitingFirstStatusAnswer,
         // Functional state
         psIdle,
-        psSendingStatusRequest,
         psWaitingStatusAnswer,
+        psWaitingControlAnswer,
+    };
+    // Status stored in preferences, only control bytes are needed to restore the state
+    struct StoredStatus
+    {
+        uint8_t     data[HaierProtocol::CONTROL_PACKET_SIZE];
     };
+    ClockFunction       mClock;
     ProtocolPhases      mPhase;
-    Mutex               mReadMutex;
-    uint8_t*            mLastPacket;
-    uint8_t             mFanModeFanSpeed;
-    uint8_t             mOtherModesFanSpeed;
+    HaierStatusSnapshot mLastStatus;
+    HaierProtocol::ControlContext   mControlContext;
     bool                mDisplayStatus;
-    bool                mForceSendControl;
-    esphome::climate::ClimateTraits         mTraits;
-    std::chrono::steady_clock::time_point   mLastByteTimestamp;         // For packet timeout
-    std::chrono::steady_clock::time_point   mLastRequestTimestamp;      // For answer timeout
-    std::chrono::steady_clock::time_point   mLastValidStatusTimestamp;  // For protocol timeout
-    std::chrono::steady_clock::time_point   mLastStatusRequest; // To request AC status
-    std::chrono::steady_clock::time_point   mLastSignalRequest; // To send WiFI signal level
+    bool                mControlPending;
+    bool                mControlRequestChanged;     // Request changed after last control packet was built
+    uint8_t             mControlRetries;
+    HaierControlRequest mControlRequest;
+    uint8_t             mSentControl[HaierProtocol::CONTROL_PACKET_SIZE];
+    bool                mOptimistic;
+    bool                mOptimisticPending;
+    HaierControlRequest mOptimisticRequest;
+    HaierFrameDecoder   mDecoder;
+#ifdef HAIER_CAPTURE_SIZE
+    HaierCapture        mCapture;
+#endif
+    uint8_t             mRepeatedStatusCounter;
+    uint32_t            mMaxPublishSilence;
+    uint32_t            mWarmUpTime;
+    uint32_t            mPacketTimeout;
+    uint32_t            mAnswerTimeout;
+    uint32_t            mCommunicationTimeout;
+    uint32_t            mStatusRequestInterval;
+    uint32_t            mFastStatusRequestInterval;
+    uint32_t            mFastPollingWindow;
+    bool                mSendWifiSignal;
+    bool                mRestoreStatus;
+    bool                mStatusSavePending;
+    uint16_t            mSavedStatusCrc;            // Saved settings, room temperature changes are not worth a write
+    uint32_t            mStatusSaveInterval;
+    esphome::ESPPreferenceObject    mStatusPreference;
+    uint32_t            mFrameGap;
+    LogStatistics       mLogStatistics;
+    PublishStatistics   mPublishStatistics;
+    OptimisticStatistics    mOptimisticStatistics;
+    ProtocolStatistics      mProtocolStatistics;
+    esphome::sensor::Sensor*    mMetricSensors[msCount];
+    uint32_t            mMetricsUpdateInterval;
+    uint32_t            mReportedAnswers;   // Answers count on last metrics update
+    uint32_t            mReportedRttTotal;
+    uint32_t            mReportedFrames;
+    uint32_t            mReportedProcessingTime;
+    uint32_t            mReportedBusBytes;
+    uint32_t            mReportedRecoveries;
+    uint8_t             mRecoveryThreshold;
+    uint32_t            mRxByteBudget;
+    uint32_t            mRxTimeBudget;              // us
+    uint8_t             mConsecutiveFailures;
+    uint32_t            mLastFrameErrors;           // Decoder errors already counted as failures
+    HaierFrameDecoder::Statistics   mLoggedDecoderStatistics;   // Decoder errors already logged
+    uint32_t            mFirstStatusRetryInterval;
+    // Timestamps in ms (mClock())
+    uint32_t            mSetupTimestamp;            // For warm up
+    uint32_t            mLastByteTimestamp;         // For packet timeout
+    uint32_t            mLastRequestTimestamp;      // For answer timeout
+    uint32_t            mLastValidStatusTimestamp;  // For protocol timeout
+    uint32_t            mLastPublishTimestamp;      // For publish heartbeat
+    uint32_t            mFastPollingEnd;            // End of fast polling window
+    bool                mFastPolling;               // Window is open, cleared when it ends
+    uint32_t            mOptimisticTimestamp;       // First not confirmed optimistic publish
+    uint32_t            mLastMetricsUpdate;
+    uint32_t            mLastStatusRequest;         // To request AC status
+    uint32_t            mLastSignalRequest;         // To send WiFI signal level
+    uint32_t            mLastStatusSave;
+    uint32_t            mFaultTimestamp;            // First failure in a row
+#ifdef HAIER_RX_TASK
+    TaskHandle_t        mRxTask;
+    HaierFrameQueue<RX_QUEUE_SIZE>  mRxQueue;
+    std::atomic<bool>   mRxResetRequest;            // Decoder reset requested by loop()
+    std::atomic<bool>   mRxReceiving;               // RX task is in the middle of a frame
+#endif
+    uint32_t            mLineFreeTimestamp;         // Line is busy with our frame or expected answer until this time
+    uint32_t            mNextDeadline;              // loop() has nothing to do before this time if there is no input
 
 };
 
@@ -0,0 +1,34 @@
+#ifndef HAIER_CLIMATE_STATE_H
+#define HAIER_CLIMATE_STATE_H
+
+#include "esphome/components/climate/climate.h"
+
+namespace esphome {
+namespace haier {
+
+// Protocol independent side of status and control messages,
+// protocol policy (see haier_protocol.h) translates them from and to messages
+
+// Pending control, merged from all calls that were not sent yet
+struct HaierControlRequest
+{
+    esphome::optional<esphome::climate::ClimateMode>        mode;
+    esphome::optional<esphome::climate::ClimateFanMode>     fanMode;
+    esphome::optional<esphome::climate::ClimateSwingMode>   swingMode;
+    esphome::optional<float>                                targetTemperature;
+};
+
+// Climate state from status message, values the message doesn't define are left as they are
+struct HaierClimateState
+{
+    esphome::climate::ClimateMode                           mode;
+    esphome::optional<esphome::climate::ClimateFanMode>     fanMode;
+    esphome::climate::ClimateSwingMode                      swingMode;
+    float                                                   targetTemperature;
+    float                                                   currentTemperature;
+};
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_CLIMATE_STATE_H
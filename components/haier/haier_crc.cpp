@@ -0,0 +1,13 @@
+#include "esphome/core/hal.h"
+#include "haier_crc.h"
+
+namespace esphome {
+namespace haier {
+
+// PROGMEM keeps the table out of RAM on ESP8266, where constant data is copied to DRAM otherwise
+constexpr Crc16TableType CRC16_TABLE PROGMEM;
+
+static_assert((sizeof(CRC16_TABLE.values) == 32) ? (CRC16_TABLE.values[1] == 0xCC01) : (CRC16_TABLE.values[1] == 0xC0C1), "Wrong CRC16 table");
+
+} // namespace haier
+} // namespace esphome
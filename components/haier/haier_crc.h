@@ -0,0 +1,77 @@
+#ifndef HAIER_CRC_H
+#define HAIER_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esphome/core/defines.h"
+#ifdef USE_ESP8266
+#include <pgmspace.h>
+#endif
+
+// CRC-16/ARC (reflected polynomial 0xA001, initial value 0) used by Haier protocol.
+// Lookup table is generated at compile time and defined once in haier_crc.cpp, in flash on ESP8266.
+// Full table takes 512 bytes, define HAIER_CRC_NIBBLE_TABLE to use 16 entries table (32 bytes)
+// and process data by nibbles
+
+namespace esphome {
+namespace haier {
+
+constexpr uint16_t CRC16_POLY = 0xA001;
+
+template<size_t SIZE, unsigned BITS>
+struct Crc16Table
+{
+    uint16_t values[SIZE];
+    constexpr Crc16Table() : values()
+    {
+        for (size_t i = 0; i < SIZE; ++i)
+        {
+            uint16_t crc = i;
+            for (unsigned b = 0; b < BITS; ++b)
+                crc = (crc & 1) ? (crc >> 1) ^ CRC16_POLY : crc >> 1;
+            values[i] = crc;
+        }
+    }
+};
+
+#ifdef HAIER_CRC_NIBBLE_TABLE
+typedef Crc16Table<16, 4> Crc16TableType;
+#else
+typedef Crc16Table<256, 8> Crc16TableType;
+#endif
+
+extern const Crc16TableType CRC16_TABLE;
+
+inline uint16_t crc16TableValue(uint8_t index)
+{
+#ifdef USE_ESP8266
+    return pgm_read_word(&CRC16_TABLE.values[index]);
+#else
+    return CRC16_TABLE.values[index];
+#endif
+}
+
+// Add one byte to CRC, allows to calculate CRC while bytes stream in
+inline uint16_t crc16Update(uint16_t crc, uint8_t value)
+{
+#ifdef HAIER_CRC_NIBBLE_TABLE
+    crc = (crc >> 4) ^ crc16TableValue((crc ^ value) & 0x0F);
+    crc = (crc >> 4) ^ crc16TableValue((crc ^ (value >> 4)) & 0x0F);
+#else
+    crc = (crc >> 8) ^ crc16TableValue((crc ^ value) & 0xFF);
+#endif
+    return crc;
+}
+
+inline uint16_t crc16(const uint8_t* message, size_t len, uint16_t initial_val = 0)
+{
+    uint16_t crc = initial_val;
+    for (size_t i = 0; i < len; ++i)
+        crc = crc16Update(crc, message[i]);
+    return crc;
+}
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_CRC_H
@@ -0,0 +1,152 @@
+#include <string.h>
+#include "haier_frame_decoder.h"
+#include "haier_crc.h"
+
+namespace esphome {
+namespace haier {
+
+HaierFrameDecoder::HaierFrameDecoder() :    mHead(0),
+                                            mTail(0),
+                                            mFrameStart(0),
+                                            mFrameSize(0),
+                                            mRejectedEnd(0),
+                                            mFrameRecovered(false),
+                                            mStatistics{0, 0, 0, 0, 0},
+                                            mVerifyCrc(false)
+{
+}
+
+void HaierFrameDecoder::setVerifyCrc(bool verify)
+{
+    mVerifyCrc = verify;
+    reset();
+}
+
+void HaierFrameDecoder::reset()
+{
+    mHead = 0;
+    mTail = 0;
+    mFrameStart = 0;
+    mFrameSize = 0;
+    mRejectedEnd = 0;
+}
+
+void HaierFrameDecoder::dropFrame()
+{
+    if (mFrameSize > 0)
+    {
+        mFrameSize = 0;
+        mHead = mFrameStart;
+        rejectFrame();
+    }
+}
+
+void HaierFrameDecoder::rejectFrame()
+{
+    // Frame header is not valid, next frame can start right after it so rescan all frame data
+    mStatistics.droppedFrames++;
+    mRejectedEnd = mTail;
+}
+
+uint8_t* HaierFrameDecoder::getWriteBuffer(size_t& freeSpace)
+{
+    if (mHead > 0)
+    {
+        // Move not processed data to the beginning of the buffer
+        size_t pending = mTail - mHead;
+        if (pending > 0)
+            memmove(mBuffer, mBuffer + mHead, pending);
+        if (mFrameSize > 0)
+            mFrameStart -= mHead;
+        mRejectedEnd = mRejectedEnd > mHead ? mRejectedEnd - mHead : 0;
+        mTail = pending;
+        mHead = 0;
+    }
+    freeSpace = BUFFER_SIZE - mTail;
+    return mBuffer + mTail;
+}
+
+void HaierFrameDecoder::commitWrite(size_t size)
+{
+    mTail += size;
+    if (mTail > BUFFER_SIZE)
+        mTail = BUFFER_SIZE;
+}
+
+HaierFrameDecoder::DecoderEvents HaierFrameDecoder::nextEvent(const uint8_t*& frame, uint8_t& size)
+{
+    while (true)
+    {
+        if (mFrameSize == 0) // Haven't found beginning of packet yet
+        {
+            const uint8_t* start = (const uint8_t*)memchr(mBuffer + mHead, HaierProtocol::FRAME_HEADER, mTail - mHead);
+            if (start == NULL)
+            {
+                mHead = mTail;
+                return deNone;
+            }
+            mHead = start - mBuffer;
+            if (mTail - mHead < 3)
+                return deNone;  // Wait for the rest of header
+            if ((mBuffer[mHead + 1] != HaierProtocol::FRAME_HEADER) || (mBuffer[mHead + 2] == HaierProtocol::FRAME_HEADER))
+            {
+                mHead++;
+                continue;
+            }
+            uint8_t val = mBuffer[mHead + 2];
+            uint8_t checkSize = mVerifyCrc ? 3 : 1; // Checksum and optional CRC
+            if ((val + checkSize + 2 > HaierProtocol::MAX_FRAME_SIZE) or (val < HaierProtocol::MIN_MESSAGE_SIZE))
+            {
+                mStatistics.wrongSizeErrors++;
+                mHead += 3;
+                continue;
+            }
+            mFrameRecovered = mHead < mRejectedEnd;  // Header of this frame is inside rejected data
+            mFrameStart = mHead + 2;
+            mFrameSize = val + checkSize;
+            mHead = mFrameStart;
+            return deFrameStarted;
+        }
+        if (mTail - mFrameStart < mFrameSize)
+            return deNone;  // Wait for the rest of packet
+        const uint8_t* packet = mBuffer + mFrameStart;
+        uint8_t packetSize = mFrameSize;
+        mFrameSize = 0;
+        // Message data is followed by checksum and optional CRC
+        uint8_t dataSize = packet[0];
+        uint8_t checksum = 0;
+        for (uint8_t i = 0; i < dataSize; ++i)
+            checksum += packet[i];
+        if (checksum != packet[dataSize])
+        {
+            mStatistics.checksumErrors++;
+            mHead = mFrameStart;
+            rejectFrame();
+            continue;
+        }
+        if (mVerifyCrc)
+        {
+            uint16_t crc = crc16(packet, dataSize);
+            uint16_t packetCrc = (packet[dataSize + 1] << 8) | packet[dataSize + 2];
+            if (crc != packetCrc)
+            {
+                mStatistics.crcErrors++;
+                mHead = mFrameStart;
+                rejectFrame();
+                continue;
+            }
+        }
+        mHead = mFrameStart + packetSize;
+        if (mFrameRecovered)
+        {
+            mStatistics.recoveredFrames++;
+            mRejectedEnd = 0;
+        }
+        frame = packet;
+        size = packetSize;
+        return deFrameReady;
+    }
+}
+
+} // namespace haier
+} // namespace esphome
@@ -0,0 +1,67 @@
+#ifndef HAIER_FRAME_DECODER_H
+#define HAIER_FRAME_DECODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "haier_protocol.h"
+
+namespace esphome {
+namespace haier {
+
+// Decoder for 0xFF 0xFF framed messages. Each HaierClimate owns its own instance.
+// Incoming data is appended in bulk to the receive buffer, complete frames are
+// returned as pointers into this buffer without copying.
+// Decoder doesn't log, it can run in RX task. Errors are only counted in statistics
+class HaierFrameDecoder
+{
+public:
+    // Receive buffer should be able to hold at least one complete message
+    static constexpr size_t BUFFER_SIZE = HaierProtocol::MAX_FRAME_SIZE * 2;
+
+    enum DecoderEvents
+    {
+        deNone = 0,
+        deFrameStarted,     // Found header and valid message size
+        deFrameReady,       // Valid frame received
+    };
+    struct Statistics
+    {
+        uint32_t    recoveredFrames;    // Valid frames found inside rejected data
+        uint32_t    droppedFrames;      // Frames rejected because of checksum, CRC or timeout
+        uint32_t    checksumErrors;
+        uint32_t    crcErrors;
+        uint32_t    wrongSizeErrors;    // Headers with not valid message size
+    };
+    HaierFrameDecoder();
+    void setVerifyCrc(bool verify);
+    // Drop all buffered data
+    void reset();
+    // Abandon current frame (for example on timeout) and rescan its data for next header
+    void dropFrame();
+    // Get space for new data, pointers returned by nextEvent are invalidated by this call
+    uint8_t* getWriteBuffer(size_t& freeSpace);
+    void commitWrite(size_t size);
+    // Scan buffered data, should be called until it returns deNone.
+    // On deFrameReady frame points to message (starting from message length byte)
+    DecoderEvents nextEvent(const uint8_t*& frame, uint8_t& size);
+    bool isReceiving() const { return mFrameSize > 0; }
+    uint8_t getPosition() const { return mTail - mFrameStart; }
+    uint8_t getExpectedSize() const { return mFrameSize; }
+    const Statistics& getStatistics() const { return mStatistics; }
+private:
+    void rejectFrame();
+    uint8_t     mBuffer[BUFFER_SIZE];
+    size_t      mHead;          // First not processed byte
+    size_t      mTail;          // End of received data
+    size_t      mFrameStart;    // Start of current frame if mFrameSize > 0
+    uint8_t     mFrameSize;     // Expected size of current frame including checksum and CRC
+    size_t      mRejectedEnd;   // End of rejected data, frames starting before it are recovered
+    bool        mFrameRecovered;
+    Statistics  mStatistics;
+    bool        mVerifyCrc;
+};
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_FRAME_DECODER_H
@@ -0,0 +1,72 @@
+#ifndef HAIER_FRAME_QUEUE_H
+#define HAIER_FRAME_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "haier_protocol.h"
+
+namespace esphome {
+namespace haier {
+
+// Complete frames waiting for loop(), should cover at least answer and one unsolicited frame
+constexpr size_t RX_QUEUE_SIZE = 4;
+
+// Fixed capacity queue of complete frames between RX task and loop().
+// Exactly one producer and one consumer, nobody blocks:
+// producer owns the slot at tail until it publishes it by incrementing tail,
+// consumer owns the slot at head until it releases it by incrementing head
+template <size_t CAPACITY>
+class HaierFrameQueue
+{
+    static_assert((CAPACITY > 0) && ((CAPACITY & (CAPACITY - 1)) == 0), "Queue capacity should be power of two");
+public:
+    HaierFrameQueue() : mHead(0), mTail(0) {}
+    // Producer side, returns false if queue is full
+    bool push(const uint8_t* data, uint8_t size)
+    {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) >= CAPACITY)
+            return false;
+        Slot& slot = mSlots[tail & (CAPACITY - 1)];
+        if (size > HaierProtocol::MAX_FRAME_SIZE)
+            size = HaierProtocol::MAX_FRAME_SIZE;
+        memcpy(slot.data, data, size);
+        slot.size = size;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    // Consumer side, returns NULL if queue is empty. Frame is valid until pop()
+    const uint8_t* front(uint8_t& size) const
+    {
+        size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+            return NULL;
+        const Slot& slot = mSlots[head & (CAPACITY - 1)];
+        size = slot.size;
+        return slot.data;
+    }
+    void pop()
+    {
+        mHead.store(mHead.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    bool empty() const
+    {
+        return mHead.load(std::memory_order_relaxed) == mTail.load(std::memory_order_acquire);
+    }
+private:
+    struct Slot
+    {
+        uint8_t     size;
+        uint8_t     data[HaierProtocol::MAX_FRAME_SIZE];
+    };
+    Slot                    mSlots[CAPACITY];
+    std::atomic<size_t>     mHead;      // Next frame to consume
+    std::atomic<size_t>     mTail;      // Next free slot
+};
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_FRAME_QUEUE_H
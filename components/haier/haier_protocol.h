@@ -0,0 +1,19 @@
+#ifndef HAIER_PROTOCOL_H
+#define HAIER_PROTOCOL_H
+
+#include "haier_smartair2.h"
+
+namespace esphome {
+namespace haier {
+
+// Protocol policy used by HaierClimate. It is selected at build time, so only one
+// protocol is compiled in and there is no runtime dispatch. HaierClimate uses only frame
+// limits, message sizes and the static functions of the policy, so another protocol (hOn)
+// is added by providing them. Framing (header scan, checksum and CRC) is protocol
+// independent, see HaierFrameDecoder
+typedef SmartAir2Protocol HaierProtocol;
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_PROTOCOL_H
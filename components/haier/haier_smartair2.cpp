@@ -0,0 +1,260 @@
+#include <string.h>
+#include "haier_smartair2.h"
+#include "haier_climate_state.h"
+#include "haier_crc.h"
+
+using namespace esphome::climate;
+
+namespace esphome {
+namespace haier {
+
+constexpr HaierPacketHeader SmartAir2Protocol::POLL_COMMAND;
+constexpr HaierPacketHeader SmartAir2Protocol::CONTROL_COMMAND;
+constexpr SmartAir2Protocol::ControlContext SmartAir2Protocol::INITIAL_CONTROL_CONTEXT;
+
+namespace
+{
+    // Sets packet field and remembers if it was changed
+    template <typename FIELD>
+    void updateField(uint8_t* message, uint8_t value, bool& changed)
+    {
+        if (FIELD::get(message) != value)
+        {
+            FIELD::set(message, value);
+            changed = true;
+        }
+    }
+
+    template <typename FIELD>
+    bool sameField(const uint8_t* first, const uint8_t* second)
+    {
+        return FIELD::get(first) == FIELD::get(second);
+    }
+}
+
+SmartAir2Protocol::AnswerTypes SmartAir2Protocol::getAnswerType(const uint8_t* message)
+{
+    switch (MsgType::get(message))
+    {
+        case hpAnswerRequestStatus:
+            return atStatus;
+        case hpAnswerError:
+            return atError;
+        case hpAnswerConfirm:
+            return atConfirm;
+        default:
+            return atUnknown;
+    }
+}
+
+uint8_t SmartAir2Protocol::encodeStatusRequest(uint8_t* message)
+{
+    memcpy(message, &POLL_COMMAND, POLL_COMMAND.msg_length);
+    return POLL_COMMAND.msg_length;
+}
+
+uint16_t SmartAir2Protocol::getSettingsCrc(const uint8_t* message, size_t size)
+{
+    // Room temperature byte counts as 0
+    uint16_t crc = crc16(message, RoomTemperature::offset);
+    crc = crc16Update(crc, 0);
+    return crc16(message + RoomTemperature::offset + 1, size - RoomTemperature::offset - 1, crc);
+}
+
+SmartAir2Protocol::ControlEncodeResults SmartAir2Protocol::encodeControl(uint8_t* message, const HaierControlRequest& request,
+                                                                         bool displayOn, const ControlContext& context)
+{
+    memcpy(message, &CONTROL_COMMAND, HEADER_SIZE);
+    bool changed = false;
+    if (request.mode.has_value())
+    {
+        switch (*request.mode)
+        {
+            case CLIMATE_MODE_OFF:
+                updateField<AcPower>(message, 0, changed);
+                break;
+
+            case CLIMATE_MODE_AUTO:
+                updateField<AcPower>(message, 1, changed);
+                updateField<AcMode>(message, ConditioningAuto, changed);
+                updateField<FanSpeed>(message, context.otherModesFanSpeed, changed);
+                break;
+
+            case CLIMATE_MODE_HEAT:
+                updateField<AcPower>(message, 1, changed);
+                updateField<AcMode>(message, ConditioningHeat, changed);
+                updateField<FanSpeed>(message, context.otherModesFanSpeed, changed);
+                break;
+
+            case CLIMATE_MODE_DRY:
+                updateField<AcPower>(message, 1, changed);
+                updateField<AcMode>(message, ConditioningDry, changed);
+                updateField<FanSpeed>(message, context.otherModesFanSpeed, changed);
+                break;
+
+            case CLIMATE_MODE_FAN_ONLY:
+                updateField<AcPower>(message, 1, changed);
+                updateField<AcMode>(message, ConditioningFan, changed);
+                updateField<FanSpeed>(message, context.fanModeFanSpeed, changed);    // Auto doesn't work in fan only mode
+                break;
+
+            case CLIMATE_MODE_COOL:
+                updateField<AcPower>(message, 1, changed);
+                updateField<AcMode>(message, ConditioningCool, changed);
+                updateField<FanSpeed>(message, context.otherModesFanSpeed, changed);
+                break;
+            default:
+                return ceUnsupportedMode;
+        }
+    }
+    //Set fan speed, if we are in fan mode, reject auto in fan mode
+    if (request.fanMode.has_value())
+    {
+        switch(request.fanMode.value())
+        {
+            case CLIMATE_FAN_LOW:
+                updateField<FanSpeed>(message, FanLow, changed);
+                break;
+            case CLIMATE_FAN_MEDIUM:
+                updateField<FanSpeed>(message, FanMid, changed);
+                break;
+            case CLIMATE_FAN_HIGH:
+                updateField<FanSpeed>(message, FanHigh, changed);
+                break;
+            case CLIMATE_FAN_AUTO:
+                if (AcMode::get(message) != ConditioningFan) //if we are not in fan only mode
+                    updateField<FanSpeed>(message, FanAuto, changed);
+                break;
+            default:
+                return ceUnsupportedFanMode;
+        }
+    }
+    //Set swing mode
+    if (request.swingMode.has_value())
+    {
+        switch(request.swingMode.value())
+        {
+            case CLIMATE_SWING_OFF:
+                updateField<UseSwingBits>(message, 0, changed);
+                updateField<SwingBoth>(message, 0, changed);
+                break;
+            case CLIMATE_SWING_VERTICAL:
+                updateField<SwingBoth>(message, 0, changed);
+                updateField<VerticalSwing>(message, 1, changed);
+                updateField<HorizontalSwing>(message, 0, changed);
+                break;
+            case CLIMATE_SWING_HORIZONTAL:
+                updateField<SwingBoth>(message, 0, changed);
+                updateField<VerticalSwing>(message, 0, changed);
+                updateField<HorizontalSwing>(message, 1, changed);
+                break;
+            case CLIMATE_SWING_BOTH:
+                updateField<SwingBoth>(message, 1, changed);
+                updateField<UseSwingBits>(message, 0, changed);
+                updateField<VerticalSwing>(message, 0, changed);
+                updateField<HorizontalSwing>(message, 0, changed);
+                break;
+        }
+    }
+    if (request.targetTemperature.has_value())
+        updateField<SetPoint>(message, *request.targetTemperature - SET_POINT_OFFSET, changed);
+    updateField<DisplayOff>(message, displayOn ? 0 : 1, changed);
+    if (!changed)
+        return ceUnchanged;
+    Cntrl::set(message, 0);
+    return ceChanged;
+}
+
+void SmartAir2Protocol::decodeStatus(const uint8_t* message, HaierClimateState& state, ControlContext& context)
+{
+    state.targetTemperature = SetPoint::get(message) + SET_POINT_OFFSET;
+    state.currentTemperature = RoomTemperature::get(message);
+    //remember the fan speed we last had for climate vs fan
+    if (AcMode::get(message) == ConditioningFan)
+        context.fanModeFanSpeed = FanSpeed::get(message);
+    else
+        context.otherModesFanSpeed = FanSpeed::get(message);
+    switch (FanSpeed::get(message))
+    {
+        case FanAuto:
+            state.fanMode = CLIMATE_FAN_AUTO;
+            break;
+        case FanMid:
+            state.fanMode = CLIMATE_FAN_MEDIUM;
+            break;
+        case FanLow:
+            state.fanMode = CLIMATE_FAN_LOW;
+            break;
+        case FanHigh:
+            state.fanMode = CLIMATE_FAN_HIGH;
+            break;
+    }
+    //climate mode
+    if (AcPower::get(message) == 0)
+        state.mode = CLIMATE_MODE_OFF;
+    else
+    {
+        // Check current hvac mode
+        switch (AcMode::get(message))
+        {
+            case ConditioningCool:
+                state.mode = CLIMATE_MODE_COOL;
+                break;
+            case ConditioningHeat:
+                state.mode = CLIMATE_MODE_HEAT;
+                break;
+            case ConditioningDry:
+                state.mode = CLIMATE_MODE_DRY;
+                break;
+            case ConditioningFan:
+                state.mode = CLIMATE_MODE_FAN_ONLY;
+                break;
+            case ConditioningAuto:
+                state.mode = CLIMATE_MODE_AUTO;
+                break;
+        }
+    }
+    // Swing mode
+    if (SwingBoth::get(message) == 0)
+    {
+        if (VerticalSwing::get(message) != 0)
+            state.swingMode = CLIMATE_SWING_VERTICAL;
+        else if (HorizontalSwing::get(message) != 0)
+            state.swingMode = CLIMATE_SWING_HORIZONTAL;
+        else
+            state.swingMode = CLIMATE_SWING_OFF;
+    }
+    else
+        state.swingMode = CLIMATE_SWING_BOTH;
+}
+
+bool SmartAir2Protocol::matchesControl(const uint8_t* answer, const uint8_t* control)
+{
+    if (!sameField<AcPower>(answer, control) || !sameField<DisplayOff>(answer, control))
+        return false;
+    // Mode, fan, set point and swing are compared only if AC is on
+    if (AcPower::get(answer) == 0)
+        return true;
+    return sameField<AcMode>(answer, control) &&
+           sameField<FanSpeed>(answer, control) &&
+           sameField<SetPoint>(answer, control) &&
+           sameField<SwingBoth>(answer, control) &&
+           sameField<VerticalSwing>(answer, control) &&
+           sameField<HorizontalSwing>(answer, control);
+}
+
+void SmartAir2Protocol::encodeSignalReport(uint8_t* message, bool connected, int8_t rssi)
+{
+    memset(message, 0, SIGNAL_PACKET_SIZE);
+    memcpy(message, &POLL_COMMAND, MsgType::offset);
+    MsgLength::set(message, SIGNAL_PACKET_SIZE);
+    MsgType::set(message, hpCommandReportNetworkStatus);
+    if (connected)
+        // RSSI -128..0 dBm to 0..100
+        SignalLevel::set(message, (uint8_t)((128 + rssi) / 1.28f));
+    else
+        NetworkStatus::set(message, 1);
+}
+
+} // namespace haier
+} // namespace esphome
@@ -0,0 +1,159 @@
+#ifndef HAIER_SMARTAIR2_H
+#define HAIER_SMARTAIR2_H
+
+#include "haier_packet.h"
+
+namespace esphome {
+namespace haier {
+
+struct HaierControlRequest;
+struct HaierClimateState;
+
+struct HaierPacketHeader
+{
+    // We skip start packet indication (0xFF 0xFF)
+    /*  0 */    uint8_t             msg_length;                 // message length
+    /*  1 */    uint8_t             reserved[6];                // 0x00 0x00 0x00 0x00 0x00 0x01
+    /*  7 */    uint8_t             msg_type;                   // type of message
+    /*  8 */    uint8_t             arguments[2];
+};
+
+// smartAir2 protocol policy: frame limits, message types, packet layout, command headers
+// and translation between messages and climate state
+struct SmartAir2Protocol
+{
+    enum ConditioningModes
+    {
+        ConditioningAuto            = 0x00,
+        ConditioningCool            = 0x01,
+        ConditioningHeat            = 0x02,
+        ConditioningFan             = 0x03,
+        ConditioningDry             = 0x04
+    };
+
+    enum FanModes
+    {
+        FanHigh                     = 0x00,
+        FanMid                      = 0x01,
+        FanLow                      = 0x02,
+        FanAuto                     = 0x03
+    };
+
+    enum MessageTypes
+    {
+        hpCommandStatus             = 0x01,
+        hpAnswerRequestStatus       = 0x02,
+        hpAnswerError               = 0x03,
+        hpAnswerConfirm             = 0x4D,
+        hpCommandReportNetworkStatus = 0xF7,
+    };
+
+    // Message layout
+    typedef HaierPacketField<0>         MsgLength;                  // message length
+    typedef HaierPacketField<7>         MsgType;                    // type of message
+    // Control bytes starts here
+    typedef HaierPacketField<11>        RoomTemperature;            // current room temperature 1°C step
+    typedef HaierPacketField<15>        Cntrl;                      // In AC => ESP packets - 0x7F, in ESP => AC packets - 0x00
+    typedef HaierPacketField<21>        AcMode;                     // See enum ConditioningModes
+    typedef HaierPacketField<23>        FanSpeed;                   // See enum FanModes
+    typedef HaierPacketField<25>        SwingBoth;                  // If 1 - swing both direction, if 0 - HorizontalSwing and VerticalSwing define vertical/horizontal/off
+    typedef HaierPacketField<26, 7, 1>  LockRemote;                 // Disable remote
+    typedef HaierPacketField<27, 0, 1>  AcPower;                    // Is ac on or off
+    typedef HaierPacketField<27, 3, 1>  HealthMode;                 // Health mode on or off
+    typedef HaierPacketField<27, 4, 1>  Compressor;                 // Compressor on or off ???
+    typedef HaierPacketField<29, 0, 1>  UseSwingBits;               // Indicate if HorizontalSwing and VerticalSwing should be used
+    typedef HaierPacketField<29, 1, 1>  TurboMode;                  // Turbo mode
+    typedef HaierPacketField<29, 2, 1>  DisableBeeper;              // Silent mode
+    typedef HaierPacketField<29, 3, 1>  HorizontalSwing;            // Horizontal swing (if SwingBoth == 0)
+    typedef HaierPacketField<29, 4, 1>  VerticalSwing;              // Vertical swing (if SwingBoth == 0) if VerticalSwing and HorizontalSwing both 0 => swing off
+    typedef HaierPacketField<29, 5, 1>  DisplayOff;                 // Led on or off
+    typedef HaierPacketField<33>        SetPoint;                   // Target temperature with 16°C offset, 1°C step
+    // WiFi signal report
+    typedef HaierPacketField<9>         NetworkStatus;              // 0 - connected, 1 - no connection
+    typedef HaierPacketField<11>        SignalLevel;                // Signal level 0..100
+
+    // Start of packet indication, sent twice
+    static constexpr uint8_t FRAME_HEADER           = 0xFF;
+    // Whole frame with 0xFF 0xFF, checksum and CRC
+    static constexpr uint8_t MAX_FRAME_SIZE         = 64;
+    // Smaller message length is not a valid message
+    static constexpr uint8_t MIN_MESSAGE_SIZE       = 8;
+    static constexpr uint8_t HEADER_SIZE            = sizeof(HaierPacketHeader);
+    static constexpr uint8_t CONTROL_PACKET_SIZE    = 34;
+    static constexpr uint8_t SIGNAL_PACKET_SIZE     = 12;
+    // Set point is sent as offset from this temperature
+    static constexpr uint8_t SET_POINT_OFFSET       = 16;
+    // Commands are sent without CRC
+    static constexpr bool USE_CRC                   = false;
+
+    static constexpr HaierPacketHeader POLL_COMMAND = {
+            .msg_length = 0x0A,
+            .reserved = { 0x00,   0x00,   0x00,   0x00,   0x00,   0x01 },
+            .msg_type = hpCommandStatus,
+            .arguments = { 0x4D, 0x01 }
+        };
+    static constexpr HaierPacketHeader CONTROL_COMMAND = {
+            .msg_length = CONTROL_PACKET_SIZE,
+            .reserved = { 0x00,   0x00,   0x00,   0x00,   0x00,   0x01 },
+            .msg_type = hpCommandStatus,
+            .arguments = { 0x4D, 0x5F }
+        };
+
+    // Status values control packet needs but climate state doesn't have
+    struct ControlContext
+    {
+        uint8_t     fanModeFanSpeed;        // Last fan speed in fan only mode, auto doesn't work there
+        uint8_t     otherModesFanSpeed;     // Last fan speed in other modes
+    };
+    static constexpr ControlContext INITIAL_CONTROL_CONTEXT = { FanMid, FanAuto };
+
+    // Answers HaierClimate reacts to
+    enum AnswerTypes
+    {
+        atUnknown = 0,
+        atStatus,               // Status, also acknowledges control
+        atError,                // Command was rejected
+        atConfirm,              // Signal report was accepted
+    };
+    static AnswerTypes getAnswerType(const uint8_t* message);
+    // Message length from its header, without 0xFF 0xFF, checksum and CRC
+    static uint8_t getMessageSize(const uint8_t* message) { return MsgLength::get(message); }
+    // Status request message, returns its size
+    static uint8_t encodeStatusRequest(uint8_t* message);
+    // CRC of status settings to detect changes worth saving, room temperature is excluded
+    static uint16_t getSettingsCrc(const uint8_t* message, size_t size);
+
+    enum ControlEncodeResults
+    {
+        ceChanged = 0,          // Message differs from the last status and should be sent
+        ceUnchanged,            // AC is already in requested state
+        ceUnsupportedMode,
+        ceUnsupportedFanMode,
+    };
+    // Builds control message in place. Control bytes of the last status should already be
+    // in the message, header is written here and requested values are applied over them
+    static ControlEncodeResults encodeControl(uint8_t* message, const HaierControlRequest& request, bool displayOn,
+                                              const ControlContext& context);
+    // Status message to climate state, remembers fan speeds for the next control packet
+    static void decodeStatus(const uint8_t* message, HaierClimateState& state, ControlContext& context);
+    // Status answer shows the state requested by control message
+    static bool matchesControl(const uint8_t* answer, const uint8_t* control);
+    // WiFi signal report of SIGNAL_PACKET_SIZE, RSSI is used only if connected
+    static void encodeSignalReport(uint8_t* message, bool connected, int8_t rssi);
+};
+
+static_assert(SmartAir2Protocol::HEADER_SIZE == 10, "Unexpected packet header layout");
+static_assert(SmartAir2Protocol::MsgLength::offset == offsetof(HaierPacketHeader, msg_length), "MsgLength field doesn't match header");
+static_assert(SmartAir2Protocol::MsgType::offset == offsetof(HaierPacketHeader, msg_type), "MsgType field doesn't match header");
+static_assert(SmartAir2Protocol::RoomTemperature::offset >= SmartAir2Protocol::HEADER_SIZE, "Control fields should follow header");
+static_assert(SmartAir2Protocol::SetPoint::offset == SmartAir2Protocol::CONTROL_PACKET_SIZE - 1, "SetPoint should be the last control byte");
+static_assert(SmartAir2Protocol::SignalLevel::offset == SmartAir2Protocol::SIGNAL_PACKET_SIZE - 1, "SignalLevel should be the last byte of signal report");
+static_assert(SmartAir2Protocol::CONTROL_PACKET_SIZE + 5 <= SmartAir2Protocol::MAX_FRAME_SIZE, "Control packet doesn't fit into frame");
+static_assert((SmartAir2Protocol::UseSwingBits::mask | SmartAir2Protocol::TurboMode::mask | SmartAir2Protocol::DisableBeeper::mask |
+               SmartAir2Protocol::HorizontalSwing::mask | SmartAir2Protocol::VerticalSwing::mask | SmartAir2Protocol::DisplayOff::mask) == 0x3F,
+               "Overlapping fields in byte 29");
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_SMARTAIR2_H
@@ -0,0 +1,64 @@
+#ifndef HAIER_STATUS_SNAPSHOT_H
+#define HAIER_STATUS_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <atomic>
+#include "haier_protocol.h"
+
+namespace esphome {
+namespace haier {
+
+// Last valid status frame, double buffered seqlock.
+// One writer, any number of readers, nobody blocks:
+// sequence is odd while writer fills the buffer readers are not using, write is published
+// by the next even value. Published buffer is (sequence / 2) & 1, reader retries only
+// if the writer could have started to overwrite the buffer it was copying
+class HaierStatusSnapshot
+{
+public:
+    HaierStatusSnapshot() : mSizes{0, 0}, mSequence(0) {}
+    void write(const uint8_t* data, size_t size)
+    {
+        if (size > HaierProtocol::MAX_FRAME_SIZE)
+            size = HaierProtocol::MAX_FRAME_SIZE;
+        uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+        uint8_t index = ((sequence >> 1) + 1) & 1;
+        mSequence.store(sequence + 1, std::memory_order_relaxed);
+        // Reader that sees new data also sees odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(mBuffers[index], data, size);
+        mSizes[index] = size;
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+    // Copy part of the last status, returns false if there is no status yet or it is too short
+    bool read(uint8_t* data, size_t offset, size_t size) const
+    {
+        while (true)
+        {
+            uint32_t sequence = mSequence.load(std::memory_order_acquire);
+            if (sequence < 2)
+                return false;
+            uint8_t index = (sequence >> 1) & 1;
+            bool valid = offset + size <= mSizes[index];
+            if (valid)
+                memcpy(data, mBuffers[index] + offset, size);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // Writer overwrites this buffer only from the second odd value after the last even one
+            if (mSequence.load(std::memory_order_relaxed) - (sequence & ~1u) <= 2)
+                return valid;
+        }
+    }
+    // Increased by 2 on every write, odd while write is in progress
+    uint32_t getSequence() const { return mSequence.load(std::memory_order_acquire); }
+private:
+    uint8_t                 mBuffers[2][HaierProtocol::MAX_FRAME_SIZE];
+    uint8_t                 mSizes[2];
+    std::atomic<uint32_t>   mSequence;
+};
+
+} // namespace haier
+} // namespace esphome
+
+#endif // HAIER_STATUS_SNAPSHOT_H
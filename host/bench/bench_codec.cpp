@@ -0,0 +1,300 @@
+// Frame codec cost on fixed corpora, without UART or protocol timing around it:
+//   valid        status frames back to back
+//   corrupted    every other frame has a flipped bit or is truncated
+//   interleaved  valid frames with noise, stray headers and wrong sizes between them
+// Decoder is fed in chunks of given size, like read_array() of what is pending.
+// Reported per frame: time (time_per_frame), heap allocations (allocs_per_frame),
+// and input bytes per second. Checksum, CRC, hex formatting, status decoding
+// and control encoding are measured separately on one status message.
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+#include "esphome/components/uart/uart.h"
+#include "host_runtime.h"
+#include "simulated_ac.h"
+#include "virtual_clock.h"
+#include "haier_climate.h"
+#include "haier_crc.h"
+
+namespace {
+    std::atomic<uint64_t> gAllocations(0);
+}
+
+void* operator new(size_t size)
+{
+    gAllocations++;
+    void* memory = malloc(size ? size : 1);
+    if (memory == nullptr)
+        throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+namespace esphome {
+namespace haier {
+// Helpers of haier_climate.cpp, not declared in headers
+uint8_t getChecksum(const uint8_t* message, size_t size);
+size_t getHex(char* buffer, size_t bufferSize, const uint8_t* message, size_t size);
+}
+}
+
+using esphome::haier::HaierFrameDecoder;
+using esphome::haier::HaierProtocol;
+using host::SimulatedAc;
+
+namespace {
+
+enum Corpora
+{
+    cValid = 0,
+    cCorrupted,
+    cInterleaved,
+};
+
+const size_t CORPUS_FRAMES = 256;
+
+void appendFrame(std::vector<uint8_t>& corpus, const uint8_t* message, size_t size)
+{
+    corpus.push_back(0xFF);
+    corpus.push_back(0xFF);
+    corpus.insert(corpus.end(), message, message + size);
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < size; ++i)
+        checksum += message[i];
+    corpus.push_back(checksum);
+}
+
+// Statuses with different room temperature, set point and mode
+std::vector<uint8_t> makeStatus(size_t index)
+{
+    SimulatedAc ac;
+    ac.setRoomTemperature(18 + index % 12);
+    ac.setSetPoint(16 + index % 15);
+    ac.setMode((index / 4) % 5);
+    return std::vector<uint8_t>(ac.getStatus(), ac.getStatus() + SimulatedAc::STATUS_SIZE);
+}
+
+// Returns number of valid frames in the corpus
+size_t makeCorpus(Corpora type, std::vector<uint8_t>& corpus)
+{
+    std::mt19937 random(1);
+    size_t valid = 0;
+    for (size_t i = 0; i < CORPUS_FRAMES; ++i)
+    {
+        std::vector<uint8_t> status = makeStatus(i);
+        if ((type == cCorrupted) && (i % 2 == 1))
+        {
+            size_t start = corpus.size();
+            appendFrame(corpus, status.data(), status.size());
+            if (i % 4 == 1)
+                corpus[start + 2 + random() % status.size()] ^= 1 << (random() % 8);
+            else
+                corpus.resize(start + 2 + status.size() / 2);
+            continue;
+        }
+        if (type == cInterleaved)
+        {
+            // Noise can contain single 0xFF, stray headers and headers with wrong size
+            size_t noise = random() % 16;
+            for (size_t n = 0; n < noise; ++n)
+                corpus.push_back(random() % 4 == 0 ? 0xFF : random() % 0x100);
+            corpus.insert(corpus.end(), { 0xFF, 0xFF, 0x03, 0xFF, 0xFF, 0xF0 });
+        }
+        appendFrame(corpus, status.data(), status.size());
+        valid++;
+    }
+    return valid;
+}
+
+void BM_Decoder(benchmark::State& state)
+{
+    Corpora type = (Corpora)state.range(0);
+    size_t chunk = state.range(1);
+    host::resetRuntime();
+    std::vector<uint8_t> corpus;
+    size_t expected = makeCorpus(type, corpus);
+    HaierFrameDecoder decoder;
+    uint64_t frames = 0;
+    uint64_t allocations = gAllocations;
+    for (auto _ : state)
+    {
+        decoder.reset();
+        size_t pos = 0;
+        size_t received = 0;
+        while (pos < corpus.size())
+        {
+            size_t freeSpace;
+            uint8_t* buffer = decoder.getWriteBuffer(freeSpace);
+            size_t count = std::min(std::min(chunk, freeSpace), corpus.size() - pos);
+            memcpy(buffer, corpus.data() + pos, count);
+            decoder.commitWrite(count);
+            pos += count;
+            const uint8_t* frame;
+            uint8_t size;
+            HaierFrameDecoder::DecoderEvents event;
+            while ((event = decoder.nextEvent(frame, size)) != HaierFrameDecoder::deNone)
+            {
+                if (event == HaierFrameDecoder::deFrameReady)
+                {
+                    benchmark::DoNotOptimize(frame);
+                    received++;
+                }
+            }
+        }
+        if (received != expected)
+        {
+            state.SkipWithError("Wrong number of decoded frames");
+            break;
+        }
+        frames += received;
+    }
+    allocations = gAllocations - allocations;
+    state.SetBytesProcessed(state.iterations() * corpus.size());
+    state.counters["time_per_frame"] = benchmark::Counter(frames, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["allocs_per_frame"] = frames > 0 ? (double)allocations / frames : 0;
+}
+
+void BM_Checksum(benchmark::State& state)
+{
+    std::vector<uint8_t> status = makeStatus(0);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(status.data());
+        benchmark::DoNotOptimize(esphome::haier::getChecksum(status.data(), status.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * status.size());
+}
+
+void BM_Crc16(benchmark::State& state)
+{
+    std::vector<uint8_t> status = makeStatus(0);
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(status.data());
+        benchmark::DoNotOptimize(esphome::haier::crc16(status.data(), status.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * status.size());
+}
+
+void BM_GetHex(benchmark::State& state)
+{
+    std::vector<uint8_t> status = makeStatus(0);
+    char buffer[HaierProtocol::MAX_FRAME_SIZE * 3 + 1];
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(status.data());
+        benchmark::DoNotOptimize(esphome::haier::getHex(buffer, sizeof(buffer), status.data(), status.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * status.size());
+}
+
+// Writes go nowhere, nothing is received
+class NullUart : public esphome::uart::UARTComponent
+{
+public:
+    void write_array(const uint8_t*, size_t) override {}
+    bool peek_byte(uint8_t*) override { return false; }
+    bool read_array(uint8_t*, size_t) override { return false; }
+    int available() override { return 0; }
+    void flush() override {}
+};
+
+// Exposes status decoding and control encoding steps
+class CodecClimate : public esphome::haier::HaierClimate
+{
+public:
+    explicit CodecClimate(esphome::uart::UARTComponent* uart) : HaierClimate(uart) {}
+    using HaierClimate::processStatus;
+    using HaierClimate::handleIncomingPacket;
+    using HaierClimate::sendControlPacket;
+};
+
+// Climate waiting for the first status, status answer is accepted after this
+void startClimate(CodecClimate& climate)
+{
+    host::VirtualClock::set(1000);
+    climate.set_clock(host::VirtualClock::now);
+    climate.set_name("Haier AC");
+    climate.set_warm_up_time(0);
+    climate.set_restore_status(false);
+    climate.setup();
+    for (int i = 0; i < 100; ++i)
+    {
+        host::VirtualClock::advance(1);
+        climate.loop();
+    }
+}
+
+// Including publish_state() without subscribers
+void BM_ProcessStatus(benchmark::State& state)
+{
+    host::resetRuntime();
+    NullUart uart;
+    CodecClimate climate(&uart);
+    std::vector<uint8_t> statuses[2] = { makeStatus(0), makeStatus(5) };
+    uint64_t allocations = gAllocations;
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        const std::vector<uint8_t>& status = statuses[index++ & 1];
+        climate.processStatus(status.data(), status.size());
+    }
+    allocations = gAllocations - allocations;
+    state.counters["allocs_per_frame"] = (double)allocations / state.iterations();
+}
+
+// Control request merged with last status and framed with checksum and CRC.
+// With perform() the call is first checked against traits like from API or automation
+void BM_EncodeControl(benchmark::State& state)
+{
+    bool perform = state.range(0) != 0;
+    host::resetRuntime();
+    NullUart uart;
+    CodecClimate climate(&uart);
+    startClimate(climate);
+    std::vector<uint8_t> status = makeStatus(0);
+    climate.handleIncomingPacket(status.data(), status.size());
+    esphome::climate::ClimateCall calls[2] = { climate.make_call(), climate.make_call() };
+    calls[0].set_target_temperature(20);
+    calls[1].set_target_temperature(21);
+    uint64_t allocations = gAllocations;
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        esphome::climate::ClimateCall& call = calls[index++ & 1];
+        if (perform)
+            call.perform();
+        else
+            climate.control(call);
+        if (!climate.sendControlPacket())
+        {
+            state.SkipWithError("Control packet was not sent");
+            break;
+        }
+    }
+    allocations = gAllocations - allocations;
+    state.counters["allocs_per_frame"] = (double)allocations / state.iterations();
+}
+
+} // namespace
+
+BENCHMARK(BM_Decoder)->ArgNames({ "corpus", "chunk" })->ArgsProduct({ { cValid, cCorrupted, cInterleaved }, { 1, 16, 256 } });
+BENCHMARK(BM_Checksum);
+BENCHMARK(BM_Crc16);
+BENCHMARK(BM_GetHex);
+BENCHMARK(BM_ProcessStatus);
+BENCHMARK(BM_EncodeControl)->ArgName("perform")->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,40 @@
+// CRC16 of a control sized message: bit by bit loop, 256 entries table
+// (default) and 16 entries table (crc_table: NIBBLE)
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+#include "crc_variants.h"
+#include "haier_crc.h"
+
+namespace {
+
+std::vector<uint8_t> makeMessage(size_t size)
+{
+    std::vector<uint8_t> message(size);
+    std::mt19937 random(size);
+    for (uint8_t& value : message)
+        value = random() & 0xFF;
+    return message;
+}
+
+template<uint16_t (*CRC)(const uint8_t*, size_t, uint16_t)>
+void BM_Crc16(benchmark::State& state)
+{
+    std::vector<uint8_t> message = makeMessage(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(CRC(message.data(), message.size(), 0));
+    state.SetBytesProcessed(state.iterations() * message.size());
+}
+
+uint16_t crc16Table(const uint8_t* message, size_t len, uint16_t initial_val)
+{
+    return esphome::haier::crc16(message, len, initial_val);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Crc16, host::crc16Bitwise)->Arg(34)->Arg(64);
+BENCHMARK_TEMPLATE(BM_Crc16, crc16Table)->Arg(34)->Arg(64);
+BENCHMARK_TEMPLATE(BM_Crc16, host::crc16Nibble)->Arg(34)->Arg(64);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,116 @@
+// Frame queue between RX task and loop() against the same ring guarded by a mutex.
+//   PushPop   one thread pushes and takes every frame, cost of the queue itself
+//   Threads   producer thread keeps the queue full, benchmark thread takes frames,
+//             time_per_frame includes waiting for the producer
+// Frame size is the argument, 40 bytes is a smartAir2 status answer.
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include "haier_frame_queue.h"
+
+using esphome::haier::HaierFrameQueue;
+using esphome::haier::HaierProtocol;
+using esphome::haier::RX_QUEUE_SIZE;
+
+namespace {
+
+// Same interface, every operation under one lock
+template <size_t CAPACITY>
+class MutexFrameQueue
+{
+public:
+    bool push(const uint8_t* data, uint8_t size)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mTail - mHead >= CAPACITY)
+            return false;
+        Slot& slot = mSlots[mTail % CAPACITY];
+        memcpy(slot.data, data, size);
+        slot.size = size;
+        mTail++;
+        return true;
+    }
+    const uint8_t* front(uint8_t& size)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mHead == mTail)
+            return nullptr;
+        const Slot& slot = mSlots[mHead % CAPACITY];
+        size = slot.size;
+        return slot.data;
+    }
+    void pop()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mHead++;
+    }
+private:
+    struct Slot
+    {
+        uint8_t     size;
+        uint8_t     data[HaierProtocol::MAX_FRAME_SIZE];
+    };
+    std::mutex  mMutex;
+    Slot        mSlots[CAPACITY];
+    size_t      mHead = 0;
+    size_t      mTail = 0;
+};
+
+template <typename Queue>
+void BM_PushPop(benchmark::State& state)
+{
+    Queue queue;
+    uint8_t size = state.range(0);
+    uint8_t data[HaierProtocol::MAX_FRAME_SIZE] = {};
+    uint8_t received = 0;
+    for (auto _ : state)
+    {
+        queue.push(data, size);
+        const uint8_t* frame = queue.front(received);
+        benchmark::DoNotOptimize(frame);
+        queue.pop();
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+template <typename Queue>
+void BM_Threads(benchmark::State& state)
+{
+    Queue queue;
+    uint8_t size = state.range(0);
+    std::atomic<bool> done(false);
+    std::thread producer([&]()
+    {
+        uint8_t data[HaierProtocol::MAX_FRAME_SIZE] = {};
+        while (!done.load(std::memory_order_relaxed))
+        {
+            if (!queue.push(data, size))
+                std::this_thread::yield();
+        }
+    });
+    for (auto _ : state)
+    {
+        uint8_t received;
+        const uint8_t* frame;
+        while ((frame = queue.front(received)) == nullptr)
+            std::this_thread::yield();
+        benchmark::DoNotOptimize(frame[0]);
+        queue.pop();
+    }
+    done = true;
+    producer.join();
+    state.SetBytesProcessed(state.iterations() * size);
+    state.counters["time_per_frame"] = benchmark::Counter(state.iterations(),
+                                                          benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_PushPop, HaierFrameQueue<RX_QUEUE_SIZE>)->ArgName("size")->Arg(13)->Arg(40)->Arg(HaierProtocol::MAX_FRAME_SIZE);
+BENCHMARK_TEMPLATE(BM_PushPop, MutexFrameQueue<RX_QUEUE_SIZE>)->ArgName("size")->Arg(13)->Arg(40)->Arg(HaierProtocol::MAX_FRAME_SIZE);
+BENCHMARK_TEMPLATE(BM_Threads, HaierFrameQueue<RX_QUEUE_SIZE>)->ArgName("size")->Arg(40)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Threads, MutexFrameQueue<RX_QUEUE_SIZE>)->ArgName("size")->Arg(40)->UseRealTime();
+
+BENCHMARK_MAIN();
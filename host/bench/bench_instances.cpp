@@ -0,0 +1,45 @@
+// loop() cost of a node with 1..4 units. Every benchmark iteration is one
+// ms of virtual time with one loop() call per unit. Units are polled with
+// default intervals and optionally send status on their own every 50 ms
+// (busy line). Cost per unit should stay the same when units are added.
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include "host_runtime.h"
+#include "haier_unit.h"
+
+namespace {
+
+void BM_NodeLoop(benchmark::State& state)
+{
+    host::resetRuntime();
+    host::VirtualClock::set(1000);
+    size_t count = state.range(0);
+    std::vector<std::unique_ptr<HaierUnit>> units;
+    for (size_t i = 0; i < count; ++i)
+    {
+        units.emplace_back(new HaierUnit("Unit"));
+        units.back()->ac.setUnsolicitedInterval(state.range(1));
+        units.back()->climate.setup();
+    }
+    for (auto _ : state)
+    {
+        host::VirtualClock::advance(1);
+        for (auto& unit : units)
+            unit->climate.loop();
+    }
+    uint64_t frames = 0;
+    for (auto& unit : units)
+        frames += unit->climate.get_protocol_statistics().rxFrames;
+    state.SetItemsProcessed(state.iterations() * count);
+    state.counters["units"] = count;
+    state.counters["rx_frames"] = frames;
+    state.counters["ns_per_unit_loop"] = benchmark::Counter(state.iterations() * count,
+                                                            benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+} // namespace
+
+BENCHMARK(BM_NodeLoop)->ArgsProduct({ { 1, 2, 3, 4 }, { 0, 50 } });
+
+BENCHMARK_MAIN();
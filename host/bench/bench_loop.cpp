@@ -0,0 +1,81 @@
+// loop() cost with deadline scheduling against running the protocol state
+// machine on every call, which is how loop() worked before. 1 and 4 units on
+// one node, each benchmark iteration is one ms of virtual time with one call
+// per unit. Units are polled with default intervals, "busy" units also send
+// status on their own every 50 ms.
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+#include "host_runtime.h"
+#include "simulated_ac.h"
+#include "simulated_uart.h"
+#include "virtual_clock.h"
+#include "haier_climate.h"
+
+namespace {
+
+// Gives access to the state machine step without deadline check
+class ScheduledClimate : public esphome::haier::HaierClimate
+{
+public:
+    explicit ScheduledClimate(esphome::uart::UARTComponent* uart) : HaierClimate(uart) {}
+    void loopEveryCall() { processProtocol(host::VirtualClock::now()); }
+};
+
+struct Unit
+{
+    Unit() : uart(ac, host::VirtualClock::now), climate(&uart)
+    {
+        climate.set_clock(host::VirtualClock::now);
+        climate.set_name("Unit");
+    }
+    host::SimulatedAc       ac;
+    host::SimulatedUart     uart;
+    ScheduledClimate        climate;
+};
+
+void BM_Loop(benchmark::State& state)
+{
+    size_t count = state.range(0);
+    bool everyCall = state.range(1) != 0;
+    host::resetRuntime();
+    host::VirtualClock::set(1000);
+    std::vector<std::unique_ptr<Unit>> units;
+    for (size_t i = 0; i < count; ++i)
+    {
+        units.emplace_back(new Unit());
+        units.back()->ac.setUnsolicitedInterval(state.range(2));
+        units.back()->climate.setup();
+    }
+    // Past warm up and first status, so all runs measure the steady state
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        host::VirtualClock::advance(1);
+        for (auto& unit : units)
+            unit->climate.loop();
+    }
+    for (auto _ : state)
+    {
+        host::VirtualClock::advance(1);
+        for (auto& unit : units)
+        {
+            if (everyCall)
+                unit->climate.loopEveryCall();
+            else
+                unit->climate.loop();
+        }
+    }
+    uint64_t frames = 0;
+    for (auto& unit : units)
+        frames += unit->climate.get_protocol_statistics().rxFrames;
+    state.SetItemsProcessed(state.iterations() * count);
+    state.counters["rx_frames"] = frames;
+    state.counters["time_per_unit_loop"] = benchmark::Counter(state.iterations() * count,
+                                                              benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+} // namespace
+
+BENCHMARK(BM_Loop)->ArgNames({ "units", "every_call", "busy_ms" })->ArgsProduct({ { 1, 4 }, { 0, 1 }, { 0, 50 } });
+
+BENCHMARK_MAIN();
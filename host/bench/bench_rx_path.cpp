@@ -0,0 +1,63 @@
+// loop() time per received status frame. "bulk" is how the component reads
+// now: everything pending is read with one read_array() and scanned in place.
+// "bytewise" limits the port to one byte per read, which is how input was
+// handled before (available() and read_byte() for every byte), through the
+// same decoder.
+#include <benchmark/benchmark.h>
+#include <vector>
+#include "host_runtime.h"
+#include "haier_unit.h"
+
+namespace {
+
+std::vector<uint8_t> makeStatusFrame(const host::SimulatedAc& ac)
+{
+    std::vector<uint8_t> frame = { 0xFF, 0xFF };
+    const uint8_t* status = ac.getStatus();
+    frame.insert(frame.end(), status, status + host::SimulatedAc::STATUS_SIZE);
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < host::SimulatedAc::STATUS_SIZE; ++i)
+        checksum += status[i];
+    frame.push_back(checksum);
+    return frame;
+}
+
+void BM_LoopPerFrame(benchmark::State& state)
+{
+    bool bytewise = state.range(0) != 0;
+    host::resetRuntime();
+    host::VirtualClock::set(1000);
+    HaierUnit unit("Unit");
+    // Only injected frames, no polling or timeouts during the run
+    unit.climate.set_status_request_interval(3600000);
+    unit.climate.set_communication_timeout(3600000);
+    unit.climate.setup();
+    while (unit.publishes == 0)
+    {
+        host::VirtualClock::advance(1);
+        unit.climate.loop();
+    }
+    unit.ac.setSilent(true);
+    std::vector<uint8_t> frame = makeStatusFrame(unit.ac);
+    if (bytewise)
+        unit.uart.setAvailableLimit(1);
+    uint32_t frames = unit.climate.get_protocol_statistics().rxFrames;
+    for (auto _ : state)
+    {
+        host::VirtualClock::advance(1);
+        unit.uart.injectBytes(frame.data(), frame.size());
+        do
+            unit.climate.loop();
+        while (unit.uart.getPending() > 0);
+    }
+    if (unit.climate.get_protocol_statistics().rxFrames - frames != state.iterations())
+        state.SkipWithError("Not all frames were received");
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * frame.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_LoopPerFrame)->ArgName("bytewise")->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,53 @@
+#include "crc_variants.h"
+
+// Nibble table variant of haier_crc.h under different names,
+// so it can be linked together with the full table variant
+#define HAIER_CRC_NIBBLE_TABLE
+#define CRC16_TABLE     CRC16_NIBBLE_TABLE
+#define crc16TableValue crc16NibbleTableValue
+#define crc16Update     crc16NibbleUpdate
+#define crc16           crc16NibbleImpl
+#include "haier_crc.h"
+
+namespace esphome {
+namespace haier {
+
+constexpr Crc16TableType CRC16_TABLE;
+
+} // namespace haier
+} // namespace esphome
+
+#undef crc16
+#undef crc16Update
+#undef crc16TableValue
+#undef CRC16_TABLE
+
+namespace host {
+
+uint16_t crc16Bitwise(const uint8_t* message, size_t len, uint16_t initial_val)
+{
+    constexpr uint16_t poly = 0xA001;
+    uint16_t crc = initial_val;
+    for (size_t i = 0; i < len; ++i)
+    {
+        crc ^= (uint16_t)message[i];
+        for (int b = 0; b < 8; ++b)
+        {
+            if ((crc & 1) != 0)
+            {
+                crc >>= 1;
+                crc ^= poly;
+            }
+            else
+                crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t crc16Nibble(const uint8_t* message, size_t len, uint16_t initial_val)
+{
+    return esphome::haier::crc16NibbleImpl(message, len, initial_val);
+}
+
+} // namespace host
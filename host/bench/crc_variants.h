@@ -0,0 +1,17 @@
+#ifndef CRC_VARIANTS_H
+#define CRC_VARIANTS_H
+
+#include <cstdint>
+#include <cstddef>
+
+// CRC16 implementations to compare with the one the component is built with
+namespace host {
+
+// Bit by bit loop the component used before the lookup table
+uint16_t crc16Bitwise(const uint8_t* message, size_t len, uint16_t initial_val = 0);
+// 16 entries table, what crc_table: NIBBLE builds
+uint16_t crc16Nibble(const uint8_t* message, size_t len, uint16_t initial_val = 0);
+
+} // namespace host
+
+#endif // CRC_VARIANTS_H
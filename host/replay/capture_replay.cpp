@@ -0,0 +1,183 @@
+#include <cstring>
+#include "virtual_clock.h"
+#include "capture_replay.h"
+
+namespace host {
+
+namespace {
+    const char* const HEX_MARKER = "Capture ";
+    const char* const BINARY_MARKER = "Capture B64:";
+    // Far enough to never poll or time out during replay, still fine for wrap-safe comparisons
+    const uint32_t REPLAY_INTERVAL = 0x3FFFFFFF;
+    // Time given to HaierClimate to send the first status request before the first record
+    const uint32_t REPLAY_LEAD_TIME = 100;
+    const uint8_t FRAME_PREFIX[] = { 0xFF, 0xFF };
+
+    int hexValue(char c)
+    {
+        if ((c >= '0') && (c <= '9'))
+            return c - '0';
+        if ((c >= 'A') && (c <= 'F'))
+            return c - 'A' + 10;
+        if ((c >= 'a') && (c <= 'f'))
+            return c - 'a' + 10;
+        return -1;
+    }
+
+    int base64Value(char c)
+    {
+        if ((c >= 'A') && (c <= 'Z'))
+            return c - 'A';
+        if ((c >= 'a') && (c <= 'z'))
+            return c - 'a' + 26;
+        if ((c >= '0') && (c <= '9'))
+            return c - '0' + 52;
+        if (c == '+')
+            return 62;
+        if (c == '/')
+            return 63;
+        return -1;
+    }
+}
+
+bool decodeBase64(const std::string& text, std::vector<uint8_t>& data)
+{
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text)
+    {
+        if (c == '=')
+            break;
+        int value = base64Value(c);
+        if (value < 0)
+            return false;
+        bits = (bits << 6) | value;
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            data.push_back((bits >> count) & 0xFF);
+        }
+    }
+    return true;
+}
+
+bool CaptureParser::addLine(const std::string& line)
+{
+    size_t pos = line.find(BINARY_MARKER);
+    if (pos != std::string::npos)
+    {
+        pos += strlen(BINARY_MARKER);
+        // Logger can add color reset sequence at the end
+        size_t end = pos;
+        while ((end < line.size()) && (base64Value(line[end]) >= 0 || line[end] == '='))
+            end++;
+        return decodeBase64(line.substr(pos, end - pos), mBinary);
+    }
+    // "Capture <timestamp> <RX|TX>: XX XX ..."
+    pos = line.find(HEX_MARKER);
+    if ((pos == std::string::npos) || (line.size() <= pos + strlen(HEX_MARKER)) ||
+        (line[pos + strlen(HEX_MARKER)] < '0') || (line[pos + strlen(HEX_MARKER)] > '9'))
+        return true;
+    const char* p = line.c_str() + pos + strlen(HEX_MARKER);
+    char* end;
+    CaptureRecord record;
+    record.timestamp = strtoul(p, &end, 10);
+    if ((strncmp(end, " RX:", 4) != 0) && (strncmp(end, " TX:", 4) != 0))
+        return false;
+    record.sent = end[1] == 'T';
+    for (p = end + 4; (p[0] == ' ') && (hexValue(p[1]) >= 0) && (hexValue(p[2]) >= 0); p += 3)
+        record.data.push_back((hexValue(p[1]) << 4) | hexValue(p[2]));
+    mRecords.push_back(std::move(record));
+    return true;
+}
+
+bool CaptureParser::finish()
+{
+    // Same layout as HaierCapture ring: direction and size, timestamp (little endian), data
+    size_t pos = 0;
+    while (pos + 5 <= mBinary.size())
+    {
+        CaptureRecord record;
+        record.sent = (mBinary[pos] & 0x80) != 0;
+        size_t size = mBinary[pos] & 0x7F;
+        record.timestamp = 0;
+        for (int i = 0; i < 4; ++i)
+            record.timestamp |= (uint32_t)mBinary[pos + 1 + i] << (8 * i);
+        if (pos + 5 + size > mBinary.size())
+            break;
+        record.data.assign(mBinary.begin() + pos + 5, mBinary.begin() + pos + 5 + size);
+        mRecords.push_back(std::move(record));
+        pos += 5 + size;
+    }
+    bool complete = pos == mBinary.size();
+    mBinary.clear();
+    return complete;
+}
+
+bool ReplayUart::peek_byte(uint8_t* data)
+{
+    if (mInput.empty())
+        return false;
+    *data = mInput.front();
+    return true;
+}
+
+bool ReplayUart::read_array(uint8_t* data, size_t len)
+{
+    if (len > mInput.size())
+        return false;
+    std::copy(mInput.begin(), mInput.begin() + len, data);
+    mInput.erase(mInput.begin(), mInput.begin() + len);
+    return true;
+}
+
+ReplayResult replayCapture(const std::vector<CaptureRecord>& records, ReplayUart& uart,
+                           esphome::haier::HaierClimate& climate, bool addFramePrefix)
+{
+    ReplayResult result;
+    if (records.empty())
+        return result;
+    climate.add_on_state_callback([&result](esphome::climate::Climate&) { result.publishes++; });
+    climate.set_clock(VirtualClock::now);
+    climate.set_restore_status(false);
+    climate.set_warm_up_time(0);
+    climate.set_status_request_interval(REPLAY_INTERVAL);
+    climate.set_fast_polling_window(0);
+    climate.set_answer_timeout(REPLAY_INTERVAL);
+    climate.set_communication_timeout(REPLAY_INTERVAL);
+    climate.set_send_wifi_signal(false);
+    VirtualClock::set(records.front().timestamp - REPLAY_LEAD_TIME);
+    climate.setup();
+    for (uint32_t i = 0; i < REPLAY_LEAD_TIME; ++i)
+    {
+        climate.loop();
+        VirtualClock::advance(1);
+    }
+    for (const CaptureRecord& record : records)
+    {
+        if (record.sent)
+        {
+            result.txRecords++;
+            continue;
+        }
+        result.rxRecords++;
+        result.rxBytes += record.data.size();
+        if ((int32_t)(record.timestamp - VirtualClock::now()) > 0)
+            VirtualClock::set(record.timestamp);
+        if (addFramePrefix)
+            uart.push(FRAME_PREFIX, sizeof(FRAME_PREFIX));
+        uart.push(record.data.data(), record.data.size());
+        // Input is handled within loop() budget, so one record can take several calls
+        for (int calls = 0; (uart.available() > 0) && (calls < 100); ++calls)
+            climate.loop();
+        climate.loop();
+    }
+    result.duration = records.back().timestamp - records.front().timestamp;
+    result.decoder = climate.get_decoder_statistics();
+    result.protocol = climate.get_protocol_statistics();
+    result.publish = climate.get_publish_statistics();
+    return result;
+}
+
+} // namespace host
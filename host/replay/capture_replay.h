@@ -0,0 +1,75 @@
+#ifndef CAPTURE_REPLAY_H
+#define CAPTURE_REPLAY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+#include "esphome/components/uart/uart.h"
+#include "haier_climate.h"
+
+namespace host {
+
+struct CaptureRecord
+{
+    bool                    sent;
+    uint32_t                timestamp;
+    std::vector<uint8_t>    data;
+};
+
+// Collects records from log output of HaierClimate::dump_capture(), both hex and binary formats.
+// Log prefixes (time, tag, colors) are ignored
+class CaptureParser
+{
+public:
+    // Returns false if line looks like capture line but can't be decoded
+    bool addLine(const std::string& line);
+    // Records of binary lines are decoded here, binary dump can't be mixed with hex lines
+    bool finish();
+    const std::vector<CaptureRecord>& getRecords() const { return mRecords; }
+private:
+    std::vector<CaptureRecord>  mRecords;
+    std::vector<uint8_t>        mBinary;
+};
+
+bool decodeBase64(const std::string& text, std::vector<uint8_t>& data);
+
+// Feeds received bytes of capture to HaierClimate in virtual time, sent bytes are dropped
+class ReplayUart : public esphome::uart::UARTComponent
+{
+public:
+    void write_array(const uint8_t* data, size_t len) override { mBytesWritten += len; }
+    bool peek_byte(uint8_t* data) override;
+    bool read_array(uint8_t* data, size_t len) override;
+    int available() override { return mInput.size(); }
+    void flush() override {}
+    void push(const uint8_t* data, size_t size) { mInput.insert(mInput.end(), data, data + size); }
+    uint64_t getBytesWritten() const { return mBytesWritten; }
+private:
+    std::deque<uint8_t> mInput;
+    uint64_t            mBytesWritten = 0;
+};
+
+struct ReplayResult
+{
+    uint32_t    rxRecords = 0;
+    uint32_t    txRecords = 0;
+    uint64_t    rxBytes = 0;
+    uint32_t    duration = 0;       // Capture time span, ms
+    uint32_t    publishes = 0;
+    esphome::haier::HaierFrameDecoder::Statistics       decoder{};
+    esphome::haier::HaierClimate::ProtocolStatistics    protocol{};
+    esphome::haier::HaierClimate::PublishStatistics     publish{};
+};
+
+// Runs records through HaierClimate decoder and status handling. Polling is effectively disabled,
+// so received status answers are handled no matter what was sent.
+// Captures made with rx_task contain frames without 0xFF 0xFF, set addFramePrefix for them.
+// climate should be freshly constructed on the given uart
+ReplayResult replayCapture(const std::vector<CaptureRecord>& records, ReplayUart& uart,
+                           esphome::haier::HaierClimate& climate, bool addFramePrefix = false);
+
+} // namespace host
+
+#endif // CAPTURE_REPLAY_H
@@ -0,0 +1,317 @@
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "esphome/core/component.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/components/climate/climate.h"
+#include "esphome/components/logger/logger.h"
+#include "esphome/components/wifi/wifi_component.h"
+#include "host_runtime.h"
+
+namespace esphome {
+
+namespace setup_priority {
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+} // namespace setup_priority
+
+namespace {
+    const std::chrono::steady_clock::time_point gStart = std::chrono::steady_clock::now();
+}
+
+uint32_t millis()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - gStart).count();
+}
+
+uint32_t micros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - gStart).count();
+}
+
+void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+    std::this_thread::yield();
+}
+
+uint32_t fnv1_hash(const std::string& str)
+{
+    uint32_t hash = 2166136261UL;
+    for (char c : str)
+    {
+        hash *= 16777619UL;
+        hash ^= (uint8_t)c;
+    }
+    return hash;
+}
+
+namespace {
+    const std::thread::id gMainThread = std::this_thread::get_id();
+    std::atomic<uint32_t> gLogLines[ESPHOME_LOG_LEVEL_VERY_VERBOSE + 1];
+    std::atomic<uint32_t> gForeignThreadLogLines(0);
+    bool gLogOutput = getenv("HAIER_HOST_LOG") != nullptr;
+    host::LogCallback gLogCallback;
+    const char* const LEVEL_LETTERS = "-EWICDVV";
+}
+
+void esp_log_printf_(int level, const char* tag, int line, const char* format, ...)
+{
+    // Same as ESPHome logger, message is formatted only if tag level allows it
+    if ((logger::global_logger != nullptr) && (level > logger::global_logger->level_for(tag)))
+        return;
+    if (std::this_thread::get_id() != gMainThread)
+        gForeignThreadLogLines++;
+    if ((level >= 0) && (level <= ESPHOME_LOG_LEVEL_VERY_VERBOSE))
+        gLogLines[level]++;
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (gLogOutput)
+        fprintf(stderr, "[%c][%s:%03d]: %s\n", LEVEL_LETTERS[level & 7], tag, line, buffer);
+    if (gLogCallback)
+        gLogCallback(level, tag, buffer);
+}
+
+namespace logger {
+namespace {
+    Logger gLogger;
+}
+Logger* global_logger = &gLogger;
+} // namespace logger
+
+namespace wifi {
+namespace {
+    WiFiComponent gWifi;
+}
+WiFiComponent* global_wifi_component = &gWifi;
+} // namespace wifi
+
+ESPPreferences* global_preferences = &host::getPreferences();
+
+namespace climate {
+
+void ClimateCall::perform()
+{
+    // Like ESPHome, values not supported by traits are dropped before control() is called
+    ClimateTraits traits = mParent->get_traits();
+    if (mMode.has_value() && !traits.supports_mode(*mMode))
+        mMode.reset();
+    if (mFanMode.has_value() && !traits.supports_fan_mode(*mFanMode))
+        mFanMode.reset();
+    if (mSwingMode.has_value() && !traits.supports_swing_mode(*mSwingMode))
+        mSwingMode.reset();
+    mParent->control(*this);
+}
+
+void Climate::publish_state()
+{
+    for (auto& callback : mStateCallbacks)
+        callback(*this);
+}
+
+} // namespace climate
+} // namespace esphome
+
+// Control is handed between runTasks() and a task with acquire/release flags,
+// so whatever one side wrote is visible to the other when it continues
+namespace {
+    struct HostTask
+    {
+        std::thread         thread;
+        std::atomic<bool>   running{false};     // Between runTasks() and next vTaskDelay()
+        std::atomic<bool>   finished{false};
+    };
+    // Thrown from vTaskDelay() to end the task
+    struct TaskStop {};
+    std::mutex gTaskMutex;      // Task list
+    std::vector<std::unique_ptr<HostTask>> gTasks;
+    std::atomic<bool> gStopTasks(false);
+    thread_local HostTask* gCurrentTask = nullptr;
+
+    // Gives control back to runTasks() and waits for the next tick
+    void waitTick(HostTask* task)
+    {
+        task->running.store(false, std::memory_order_release);
+        while (!task->running.load(std::memory_order_acquire) && !gStopTasks.load(std::memory_order_acquire))
+            std::this_thread::yield();
+        if (gStopTasks.load(std::memory_order_acquire))
+            throw TaskStop();
+    }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle)
+{
+    HostTask* task = new HostTask();
+    {
+        std::lock_guard<std::mutex> lock(gTaskMutex);
+        gTasks.emplace_back(task);
+    }
+    task->thread = std::thread([task, function, parameter]()
+    {
+        gCurrentTask = task;
+        try
+        {
+            waitTick(task);
+            function(parameter);
+        }
+        catch (const TaskStop&)
+        {
+        }
+        task->finished.store(true, std::memory_order_release);
+        task->running.store(false, std::memory_order_release);
+    });
+    if (handle != nullptr)
+        *handle = task;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (gCurrentTask != nullptr)
+        waitTick(gCurrentTask);
+}
+
+namespace host {
+
+void setLogOutput(bool enabled)
+{
+    esphome::gLogOutput = enabled;
+}
+
+void setLogCallback(LogCallback callback)
+{
+    esphome::gLogCallback = std::move(callback);
+}
+
+uint32_t getLogLines(int level)
+{
+    return ((level >= 0) && (level <= ESPHOME_LOG_LEVEL_VERY_VERBOSE)) ? esphome::gLogLines[level].load() : 0;
+}
+
+uint32_t getForeignThreadLogLines()
+{
+    return esphome::gForeignThreadLogLines.load();
+}
+
+void resetLogCounters()
+{
+    for (auto& lines : esphome::gLogLines)
+        lines = 0;
+    esphome::gForeignThreadLogLines = 0;
+}
+
+class HostPreferences::Backend : public esphome::ESPPreferenceBackend
+{
+public:
+    Backend(HostPreferences& owner, size_t length) : mOwner(owner), mLength(length) {}
+    bool save(const uint8_t* data, size_t len) override
+    {
+        if (len != mLength)
+            return false;
+        mData.assign(data, data + len);
+        mOwner.mSaves++;
+        return true;
+    }
+    bool load(uint8_t* data, size_t len) override
+    {
+        if ((len != mLength) || (mData.size() != len))
+            return false;
+        memcpy(data, mData.data(), len);
+        return true;
+    }
+    void clear() { mData.clear(); }
+private:
+    HostPreferences& mOwner;
+    size_t mLength;
+    std::vector<uint8_t> mData;
+};
+
+esphome::ESPPreferenceObject HostPreferences::make_preference(size_t length, uint32_t type, bool in_flash)
+{
+    std::unique_ptr<Backend>& backend = mBackends[type];
+    if (!backend)
+        backend.reset(new Backend(*this, length));
+    return esphome::ESPPreferenceObject(backend.get());
+}
+
+esphome::ESPPreferenceObject HostPreferences::make_preference(size_t length, uint32_t type)
+{
+    return make_preference(length, type, false);
+}
+
+void HostPreferences::clear()
+{
+    // Objects already handed out keep pointing to their backends
+    for (auto& backend : mBackends)
+        backend.second->clear();
+    mSaves = 0;
+}
+
+HostPreferences& getPreferences()
+{
+    static HostPreferences preferences;
+    return preferences;
+}
+
+void runTasks()
+{
+    std::lock_guard<std::mutex> lock(gTaskMutex);
+    for (auto& task : gTasks)
+    {
+        if (task->finished.load(std::memory_order_acquire))
+            continue;
+        task->running.store(true, std::memory_order_release);
+        while (task->running.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+}
+
+void stopTasks()
+{
+    std::vector<std::unique_ptr<HostTask>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(gTaskMutex);
+        tasks.swap(gTasks);
+    }
+    gStopTasks.store(true, std::memory_order_release);
+    for (auto& task : tasks)
+        task->thread.join();
+    gStopTasks.store(false, std::memory_order_release);
+}
+
+void resetRuntime()
+{
+    stopTasks();
+    esphome::logger::global_logger->clear_log_levels();
+    esphome::wifi::global_wifi_component->set_connected(true);
+    esphome::wifi::global_wifi_component->set_rssi(-60);
+    getPreferences().clear();
+    resetLogCounters();
+    setLogCallback(LogCallback());
+}
+
+} // namespace host
@@ -0,0 +1,55 @@
+#ifndef HOST_RUNTIME_H
+#define HOST_RUNTIME_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+#include "esphome/core/preferences.h"
+
+// Host implementation of the ESPHome core services used by the component:
+// time, logging, preferences, FreeRTOS tasks, WiFi and logger singletons
+namespace host {
+
+// Log lines are counted always and printed to stderr only if enabled
+// (or HAIER_HOST_LOG environment variable is set)
+void setLogOutput(bool enabled);
+// Called for every emitted line with formatted message, empty function removes it
+typedef std::function<void(int level, const char* tag, const char* message)> LogCallback;
+void setLogCallback(LogCallback callback);
+// Emitted lines by level, lines logged from other threads than main are counted separately
+uint32_t getLogLines(int level);
+uint32_t getForeignThreadLogLines();
+void resetLogCounters();
+
+// Preferences kept in memory, survive HaierClimate instances within one process
+class HostPreferences : public esphome::ESPPreferences
+{
+public:
+    esphome::ESPPreferenceObject make_preference(size_t length, uint32_t type, bool in_flash) override;
+    esphome::ESPPreferenceObject make_preference(size_t length, uint32_t type) override;
+    bool sync() override { return true; }
+    void clear();
+    uint32_t getSaves() const { return mSaves; }
+private:
+    class Backend;
+    std::map<uint32_t, std::unique_ptr<Backend>> mBackends;
+    uint32_t mSaves = 0;
+};
+HostPreferences& getPreferences();
+
+// FreeRTOS tasks are threads running in lockstep with the caller: runTasks() lets every
+// task run until its next vTaskDelay() and waits for it. One call is one tick,
+// tasks never run at the same time as loop()
+void runTasks();
+// Ends all tasks at their next vTaskDelay() and joins them, call before their components are destroyed
+void stopTasks();
+
+// Stops tasks, restores default logger levels, WiFi state, removes log callback and clears preferences
+void resetRuntime();
+
+} // namespace host
+
+#endif // HOST_RUNTIME_H
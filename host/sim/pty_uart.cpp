@@ -0,0 +1,196 @@
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "esphome/core/hal.h"
+#include "pty_uart.h"
+
+namespace host {
+
+namespace
+{
+    // Raw 9600 8N1, no echo and no line discipline processing of 0xFF or line ends
+    bool setRaw(int fd)
+    {
+        struct termios settings;
+        if (tcgetattr(fd, &settings) != 0)
+            return false;
+        cfmakeraw(&settings);
+        cfsetispeed(&settings, B9600);
+        cfsetospeed(&settings, B9600);
+        settings.c_cflag |= CLOCAL | CREAD;
+        settings.c_cc[VMIN] = 0;
+        settings.c_cc[VTIME] = 0;
+        return tcsetattr(fd, TCSANOW, &settings) == 0;
+    }
+
+    void writeAll(int fd, const uint8_t* data, size_t len)
+    {
+        while (len > 0)
+        {
+            ssize_t written = ::write(fd, data, len);
+            if (written < 0)
+            {
+                if ((errno == EAGAIN) || (errno == EINTR))
+                {
+                    usleep(100);
+                    continue;
+                }
+                return;
+            }
+            data += written;
+            len -= written;
+        }
+    }
+}
+
+SerialUart::SerialUart() : mFd(-1), mPeeked(false), mPeekedByte(0)
+{
+}
+
+SerialUart::~SerialUart()
+{
+    if (mFd >= 0)
+        close(mFd);
+}
+
+bool SerialUart::open(const std::string& path)
+{
+    mFd = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (mFd < 0)
+        return false;
+    return setRaw(mFd);
+}
+
+void SerialUart::write_array(const uint8_t* data, size_t len)
+{
+    writeAll(mFd, data, len);
+}
+
+int SerialUart::available()
+{
+    int pending = 0;
+    if (ioctl(mFd, FIONREAD, &pending) != 0)
+        pending = 0;
+    return pending + (mPeeked ? 1 : 0);
+}
+
+bool SerialUart::peek_byte(uint8_t* data)
+{
+    if (!mPeeked)
+    {
+        if (::read(mFd, &mPeekedByte, 1) != 1)
+            return false;
+        mPeeked = true;
+    }
+    *data = mPeekedByte;
+    return true;
+}
+
+bool SerialUart::read_array(uint8_t* data, size_t len)
+{
+    if (len == 0)
+        return true;
+    if ((size_t)available() < len)
+        return false;
+    if (mPeeked)
+    {
+        *data++ = mPeekedByte;
+        len--;
+        mPeeked = false;
+    }
+    while (len > 0)
+    {
+        ssize_t count = ::read(mFd, data, len);
+        if (count <= 0)
+        {
+            if ((count < 0) && (errno != EAGAIN) && (errno != EINTR))
+                return false;
+            continue;
+        }
+        data += count;
+        len -= count;
+    }
+    return true;
+}
+
+void SerialUart::flush()
+{
+    tcdrain(mFd);
+}
+
+PtyAc::PtyAc(SimulatedAc& ac) : mAc(ac), mMaster(-1), mSlave(-1), mRunning(false)
+{
+}
+
+PtyAc::~PtyAc()
+{
+    stop();
+    if (mSlave >= 0)
+        close(mSlave);
+    if (mMaster >= 0)
+        close(mMaster);
+}
+
+bool PtyAc::open()
+{
+    mMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((mMaster < 0) || (grantpt(mMaster) != 0) || (unlockpt(mMaster) != 0))
+        return false;
+    const char* name = ptsname(mMaster);
+    if (name == nullptr)
+        return false;
+    mSlavePath = name;
+    // Terminal settings belong to slave side, make it raw before anybody writes
+    mSlave = ::open(name, O_RDWR | O_NOCTTY);
+    if (mSlave < 0)
+        return false;
+    fcntl(mMaster, F_SETFL, fcntl(mMaster, F_GETFL) | O_NONBLOCK);
+    return setRaw(mSlave);
+}
+
+void PtyAc::poll(int timeoutMs)
+{
+    struct pollfd fds = { mMaster, POLLIN, 0 };
+    uint8_t buffer[256];
+    if ((::poll(&fds, 1, timeoutMs) > 0) && (fds.revents & POLLIN))
+    {
+        ssize_t count = ::read(mMaster, buffer, sizeof(buffer));
+        if (count > 0)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mAc.receive(buffer, count, esphome::millis());
+        }
+    }
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        uint32_t now = esphome::millis();
+        mAc.available(now);
+        count = mAc.read(buffer, sizeof(buffer), now);
+    }
+    if (count > 0)
+        writeAll(mMaster, buffer, count);
+}
+
+void PtyAc::start()
+{
+    mRunning = true;
+    mThread = std::thread([this]()
+    {
+        while (mRunning)
+            poll(1);
+    });
+}
+
+void PtyAc::stop()
+{
+    mRunning = false;
+    if (mThread.joinable())
+        mThread.join();
+}
+
+} // namespace host
@@ -0,0 +1,61 @@
+#ifndef PTY_UART_H
+#define PTY_UART_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "esphome/components/uart/uart.h"
+#include "simulated_ac.h"
+
+namespace host {
+
+// UART on a serial device: pseudo-terminal of PtyAc or real USB-serial adapter (9600 8N1)
+class SerialUart : public esphome::uart::UARTComponent
+{
+public:
+    SerialUart();
+    ~SerialUart() override;
+    bool open(const std::string& path);
+    void write_array(const uint8_t* data, size_t len) override;
+    bool peek_byte(uint8_t* data) override;
+    bool read_array(uint8_t* data, size_t len) override;
+    int available() override;
+    void flush() override;
+private:
+    int     mFd;
+    bool    mPeeked;
+    uint8_t mPeekedByte;
+};
+
+// SimulatedAc served on the master side of a pseudo-terminal, slave side behaves like a serial port.
+// Unit runs in its own thread in real time (millis())
+class PtyAc
+{
+public:
+    explicit PtyAc(SimulatedAc& ac);
+    ~PtyAc();
+    // Creates pseudo-terminal, returns false on error
+    bool open();
+    const std::string& getSlavePath() const { return mSlavePath; }
+    // Serve in background thread until stop(), or in the calling thread with poll()
+    void start();
+    void stop();
+    void poll(int timeoutMs);
+    // Locks unit state against the serving thread
+    std::mutex& getMutex() { return mMutex; }
+private:
+    SimulatedAc&        mAc;
+    int                 mMaster;
+    int                 mSlave;     // Kept open so master doesn't see hang up before port user opens it
+    std::string         mSlavePath;
+    std::thread         mThread;
+    std::atomic<bool>   mRunning;
+    std::mutex          mMutex;
+};
+
+} // namespace host
+
+#endif // PTY_UART_H
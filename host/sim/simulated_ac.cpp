@@ -0,0 +1,201 @@
+#include <cstring>
+#include "simulated_ac.h"
+
+namespace host {
+
+namespace
+{
+    const uint8_t HEADER = 0xFF;
+    // 0x00 0x00 0x00 0x00 0x00 0x01 after message length
+    const uint8_t RESERVED[6] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+    uint16_t crc16(const uint8_t* data, size_t size)
+    {
+        uint16_t crc = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc ^= data[i];
+            for (int b = 0; b < 8; ++b)
+                crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+        }
+        return crc;
+    }
+}
+
+constexpr uint8_t SimulatedAc::STATUS_SIZE;
+constexpr uint8_t SimulatedAc::CONTROL_SIZE;
+
+SimulatedAc::SimulatedAc() :    mLineFree(0),
+                                mAnswerDelay(20),
+                                mSilent(false),
+                                mIgnoreControl(false),
+                                mRejectControl(false),
+                                mSendCrc(false),
+                                mUnsolicitedInterval(0),
+                                mLastUnsolicited(0),
+                                mLastControlTime(0),
+                                mStatistics{}
+{
+    memset(mStatus, 0, sizeof(mStatus));
+    mStatus[0] = STATUS_SIZE;
+    memcpy(mStatus + 1, RESERVED, sizeof(RESERVED));
+    mStatus[OFFSET_TYPE] = TYPE_STATUS;
+    mStatus[OFFSET_ARGUMENTS] = 0x6D;
+    mStatus[OFFSET_ARGUMENTS + 1] = 0x01;
+    mStatus[OFFSET_CNTRL] = 0x7F;
+    mStatus[OFFSET_ROOM_TEMPERATURE] = 24;
+    mStatus[OFFSET_MODE] = 0x01;        // Cool
+    mStatus[OFFSET_FAN] = 0x03;         // Auto
+    mStatus[OFFSET_SET_POINT] = 24 - 16;
+}
+
+void SimulatedAc::setPower(bool on)
+{
+    mStatus[OFFSET_POWER] = (mStatus[OFFSET_POWER] & ~0x01) | (on ? 0x01 : 0x00);
+}
+
+void SimulatedAc::receive(const uint8_t* data, size_t size, uint32_t now)
+{
+    mInput.insert(mInput.end(), data, data + size);
+    size_t pos = 0;
+    while (true)
+    {
+        // Find 0xFF 0xFF followed by message length
+        while ((pos + 1 < mInput.size()) && !((mInput[pos] == HEADER) && (mInput[pos + 1] == HEADER)))
+            pos++;
+        if (pos + 3 > mInput.size())
+            break;
+        uint8_t length = mInput[pos + 2];
+        if ((length < 10) || (length == HEADER))
+        {
+            mStatistics.brokenFrames++;
+            pos += 2;
+            continue;
+        }
+        if (pos + 2 + length + 1 > mInput.size())
+            break;  // Wait for the rest of the frame
+        const uint8_t* message = mInput.data() + pos + 2;
+        uint8_t checksum = 0;
+        for (uint8_t i = 0; i < length; ++i)
+            checksum += message[i];
+        if (checksum != message[length])
+        {
+            mStatistics.brokenFrames++;
+            pos += 2;
+            continue;
+        }
+        handleFrame(message, length, now);
+        pos += 2 + length + 1;
+    }
+    mInput.erase(mInput.begin(), mInput.begin() + pos);
+}
+
+void SimulatedAc::handleFrame(const uint8_t* message, uint8_t size, uint32_t now)
+{
+    uint8_t type = message[OFFSET_TYPE];
+    if ((type == TYPE_COMMAND) && (message[OFFSET_ARGUMENTS] == 0x4D) && (message[OFFSET_ARGUMENTS + 1] == 0x01))
+    {
+        mStatistics.statusRequests++;
+        if (!mSilent)
+            sendMessage(mStatus, STATUS_SIZE, now);
+    }
+    else if ((type == TYPE_COMMAND) && (message[OFFSET_ARGUMENTS] == 0x4D) && (message[OFFSET_ARGUMENTS + 1] == 0x5F) && (size >= CONTROL_SIZE))
+    {
+        mStatistics.controlCommands++;
+        mLastControlTime = now;
+        if (mSilent)
+            return;
+        if (mRejectControl)
+        {
+            uint8_t error[10] = { 10, 0, 0, 0, 0, 0, 1, TYPE_ERROR, 0, 0 };
+            sendMessage(error, sizeof(error), now);
+            return;
+        }
+        // Everything after command arguments except room temperature and direction marker
+        if (!mIgnoreControl)
+            for (uint8_t i = OFFSET_CNTRL + 1; i < CONTROL_SIZE; ++i)
+                mStatus[i] = message[i];
+        sendMessage(mStatus, STATUS_SIZE, now);
+    }
+    else if (type == TYPE_NETWORK_STATUS)
+    {
+        mStatistics.signalReports++;
+        if (!mSilent)
+        {
+            uint8_t confirm[10] = { 10, 0, 0, 0, 0, 0, 1, TYPE_CONFIRM, 0, 0 };
+            sendMessage(confirm, sizeof(confirm), now);
+        }
+    }
+    else
+        mStatistics.unknownCommands++;
+}
+
+void SimulatedAc::sendStatus(uint32_t now)
+{
+    sendMessage(mStatus, STATUS_SIZE, now);
+}
+
+void SimulatedAc::sendMessage(const uint8_t* message, uint8_t size, uint32_t now)
+{
+    uint8_t frame[2 + 255 + 3];
+    size_t frameSize = 0;
+    frame[frameSize++] = HEADER;
+    frame[frameSize++] = HEADER;
+    memcpy(frame + frameSize, message, size);
+    frameSize += size;
+    uint8_t checksum = 0;
+    for (uint8_t i = 0; i < size; ++i)
+        checksum += message[i];
+    frame[frameSize++] = checksum;
+    if (mSendCrc)
+    {
+        uint16_t crc = crc16(message, size);
+        frame[frameSize++] = crc >> 8;
+        frame[frameSize++] = crc & 0xFF;
+    }
+    // Frames don't overlap on the line, bytes follow each other with line speed
+    uint32_t start = now + mAnswerDelay;
+    // Line end is compared only while something is queued, it can be more than 2^31 ms old
+    if (!mOutput.empty() && ((int32_t)(start - mLineFree) < 0))
+        start = mLineFree;
+    for (size_t i = 0; i < frameSize; ++i)
+        mOutput.push_back(PendingByte{ start + (uint32_t)(((i + 1) * BYTE_TIME_US + 999) / 1000), frame[i] });
+    mLineFree = start + (uint32_t)((frameSize * BYTE_TIME_US + 999) / 1000);
+    mStatistics.framesSent++;
+    mStatistics.bytesSent += frameSize;
+}
+
+void SimulatedAc::update(uint32_t now)
+{
+    if ((mUnsolicitedInterval > 0) && !mSilent && ((now - mLastUnsolicited) >= mUnsolicitedInterval))
+    {
+        mLastUnsolicited = now;
+        sendStatus(now);
+    }
+}
+
+size_t SimulatedAc::available(uint32_t now)
+{
+    update(now);
+    size_t count = 0;
+    for (const PendingByte& pending : mOutput)
+    {
+        if ((int32_t)(now - pending.time) < 0)
+            break;
+        count++;
+    }
+    return count;
+}
+
+size_t SimulatedAc::read(uint8_t* data, size_t size, uint32_t now)
+{
+    size_t count = 0;
+    while ((count < size) && !mOutput.empty() && ((int32_t)(now - mOutput.front().time) >= 0))
+    {
+        data[count++] = mOutput.front().value;
+        mOutput.pop_front();
+    }
+    return count;
+}
+
+} // namespace host
@@ -0,0 +1,118 @@
+#ifndef SIMULATED_AC_H
+#define SIMULATED_AC_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+namespace host {
+
+// smartAir2 indoor unit as seen from the UART: answers status requests and
+// control packets with status frames, confirms WiFi signal reports.
+// Packet layout is written down here independently from the component
+// so the simulator can catch layout mistakes instead of repeating them.
+// Time is passed in by the caller, so the same unit works in real and virtual time
+class SimulatedAc
+{
+public:
+    static constexpr uint8_t STATUS_SIZE            = 0x25;
+    static constexpr uint8_t CONTROL_SIZE           = 0x22;
+    // Message layout, offsets start from message length byte
+    static constexpr uint8_t OFFSET_TYPE            = 7;
+    static constexpr uint8_t OFFSET_ARGUMENTS       = 8;
+    static constexpr uint8_t OFFSET_ROOM_TEMPERATURE = 11;
+    static constexpr uint8_t OFFSET_CNTRL           = 15;
+    static constexpr uint8_t OFFSET_MODE            = 21;
+    static constexpr uint8_t OFFSET_FAN             = 23;
+    static constexpr uint8_t OFFSET_SWING_BOTH      = 25;
+    static constexpr uint8_t OFFSET_POWER           = 27;   // Bit 0
+    static constexpr uint8_t OFFSET_FLAGS           = 29;   // Swing bits and display
+    static constexpr uint8_t OFFSET_SET_POINT       = 33;
+    static constexpr uint8_t FLAG_USE_SWING_BITS    = 0x01;
+    static constexpr uint8_t FLAG_HORIZONTAL_SWING  = 0x08;
+    static constexpr uint8_t FLAG_VERTICAL_SWING    = 0x10;
+    static constexpr uint8_t FLAG_DISPLAY_OFF       = 0x20;
+    // Message types
+    static constexpr uint8_t TYPE_COMMAND           = 0x01;
+    static constexpr uint8_t TYPE_STATUS            = 0x02;
+    static constexpr uint8_t TYPE_ERROR             = 0x03;
+    static constexpr uint8_t TYPE_CONFIRM           = 0x4D;
+    static constexpr uint8_t TYPE_NETWORK_STATUS    = 0xF7;
+    // Line time of one byte at 9600 baud
+    static constexpr uint32_t BYTE_TIME_US          = 1042;
+
+    struct Statistics
+    {
+        uint32_t    statusRequests;
+        uint32_t    controlCommands;
+        uint32_t    signalReports;
+        uint32_t    unknownCommands;
+        uint32_t    brokenFrames;       // Wrong checksum or size
+        uint32_t    framesSent;
+        uint32_t    bytesSent;
+    };
+
+    SimulatedAc();
+    // Bytes written by ESP, every complete frame is answered after answer delay
+    void receive(const uint8_t* data, size_t size, uint32_t now);
+    // Number of bytes already on the line at this time
+    size_t available(uint32_t now);
+    size_t read(uint8_t* data, size_t size, uint32_t now);
+    // Queue status frame as if state was changed by IR remote
+    void sendStatus(uint32_t now);
+
+    void setAnswerDelay(uint32_t delayMs) { mAnswerDelay = delayMs; }
+    // Don't answer anything, like unit that is still booting
+    void setSilent(bool silent) { mSilent = silent; }
+    // Answer control packets with unchanged status
+    void setIgnoreControl(bool ignore) { mIgnoreControl = ignore; }
+    // Answer control packets with error message
+    void setRejectControl(bool reject) { mRejectControl = reject; }
+    // Append CRC16 to sent frames
+    void setSendCrc(bool send) { mSendCrc = send; }
+    // Send status without request every interval, 0 - disabled
+    void setUnsolicitedInterval(uint32_t intervalMs) { mUnsolicitedInterval = intervalMs; }
+
+    bool isPowerOn() const { return mStatus[OFFSET_POWER] & 0x01; }
+    uint8_t getMode() const { return mStatus[OFFSET_MODE]; }
+    uint8_t getFanSpeed() const { return mStatus[OFFSET_FAN]; }
+    uint8_t getSetPoint() const { return mStatus[OFFSET_SET_POINT] + 16; }
+    bool isSwingBoth() const { return mStatus[OFFSET_SWING_BOTH] != 0; }
+    uint8_t getFlags() const { return mStatus[OFFSET_FLAGS]; }
+    bool isDisplayOff() const { return mStatus[OFFSET_FLAGS] & FLAG_DISPLAY_OFF; }
+    uint8_t getRoomTemperature() const { return mStatus[OFFSET_ROOM_TEMPERATURE]; }
+    void setRoomTemperature(uint8_t temperature) { mStatus[OFFSET_ROOM_TEMPERATURE] = temperature; }
+    void setPower(bool on);
+    void setMode(uint8_t mode) { mStatus[OFFSET_MODE] = mode; }
+    void setSetPoint(uint8_t temperature) { mStatus[OFFSET_SET_POINT] = temperature - 16; }
+    const uint8_t* getStatus() const { return mStatus; }
+    const Statistics& getStatistics() const { return mStatistics; }
+    uint32_t getLastControlTime() const { return mLastControlTime; }
+private:
+    void handleFrame(const uint8_t* message, uint8_t size, uint32_t now);
+    void sendMessage(const uint8_t* message, uint8_t size, uint32_t now);
+    void update(uint32_t now);
+    uint8_t                 mStatus[STATUS_SIZE];
+    std::vector<uint8_t>    mInput;
+    struct PendingByte
+    {
+        uint32_t    time;
+        uint8_t     value;
+    };
+    std::deque<PendingByte> mOutput;
+    uint32_t                mLineFree;      // End of last queued frame
+    uint32_t                mAnswerDelay;
+    bool                    mSilent;
+    bool                    mIgnoreControl;
+    bool                    mRejectControl;
+    bool                    mSendCrc;
+    uint32_t                mUnsolicitedInterval;
+    uint32_t                mLastUnsolicited;
+    uint32_t                mLastControlTime;
+    Statistics              mStatistics;
+};
+
+} // namespace host
+
+#endif // SIMULATED_AC_H
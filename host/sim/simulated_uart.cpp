@@ -0,0 +1,87 @@
+#include "simulated_uart.h"
+
+namespace host {
+
+SimulatedUart::SimulatedUart(SimulatedAc& ac, ClockFunction clock) :    mAc(ac),
+                                                                        mClock(clock),
+                                                                        mRandom(1),
+                                                                        mDropRate(0.0),
+                                                                        mFlipRate(0.0),
+                                                                        mUnplugged(false),
+                                                                        mAvailableLimit(SIZE_MAX),
+                                                                        mBytesRead(0),
+                                                                        mBytesWritten(0)
+{
+}
+
+void SimulatedUart::write_array(const uint8_t* data, size_t len)
+{
+    mBytesWritten += len;
+    if (!mUnplugged)
+        mAc.receive(data, len, mClock());
+}
+
+void SimulatedUart::pump()
+{
+    uint32_t now = mClock();
+    uint8_t buffer[64];
+    size_t count;
+    while ((count = mAc.read(buffer, sizeof(buffer), now)) > 0)
+    {
+        if (mUnplugged)
+            continue;
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if ((mDropRate > 0.0) && (chance(mRandom) < mDropRate))
+                continue;
+            uint8_t value = buffer[i];
+            if ((mFlipRate > 0.0) && (chance(mRandom) < mFlipRate))
+                value ^= 1 << (mRandom() % 8);
+            mInput.push_back(value);
+        }
+    }
+}
+
+void SimulatedUart::injectNoise(size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        mInput.push_back(mRandom() & 0xFF);
+}
+
+void SimulatedUart::injectBytes(const uint8_t* data, size_t size)
+{
+    mInput.insert(mInput.end(), data, data + size);
+}
+
+int SimulatedUart::available()
+{
+    mAc.available(mClock());
+    pump();
+    return mInput.size() < mAvailableLimit ? mInput.size() : mAvailableLimit;
+}
+
+bool SimulatedUart::peek_byte(uint8_t* data)
+{
+    pump();
+    if (mInput.empty())
+        return false;
+    *data = mInput.front();
+    return true;
+}
+
+bool SimulatedUart::read_array(uint8_t* data, size_t len)
+{
+    pump();
+    if (mInput.size() < len)
+        return false;
+    for (size_t i = 0; i < len; ++i)
+    {
+        data[i] = mInput.front();
+        mInput.pop_front();
+    }
+    mBytesRead += len;
+    return true;
+}
+
+} // namespace host
@@ -0,0 +1,56 @@
+#ifndef SIMULATED_UART_H
+#define SIMULATED_UART_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <random>
+#include "esphome/components/uart/uart.h"
+#include "simulated_ac.h"
+
+namespace host {
+
+// In-memory UART between HaierClimate and SimulatedAc.
+// Faults are applied to the bytes going from AC to ESP
+class SimulatedUart : public esphome::uart::UARTComponent
+{
+public:
+    typedef uint32_t (*ClockFunction)();
+    SimulatedUart(SimulatedAc& ac, ClockFunction clock);
+    void write_array(const uint8_t* data, size_t len) override;
+    bool peek_byte(uint8_t* data) override;
+    bool read_array(uint8_t* data, size_t len) override;
+    int available() override;
+    void flush() override {}
+
+    // Probability for every byte to be lost or to get one bit flipped
+    void setDropRate(double rate) { mDropRate = rate; }
+    void setFlipRate(double rate) { mFlipRate = rate; }
+    // Nothing goes in either direction
+    void setUnplugged(bool unplugged) { mUnplugged = unplugged; }
+    // Random bytes, available right away
+    void injectNoise(size_t size);
+    void injectBytes(const uint8_t* data, size_t size);
+    // available() reports not more than this, 1 makes the reader handle input byte by byte
+    void setAvailableLimit(size_t limit) { mAvailableLimit = limit; }
+    void setSeed(uint32_t seed) { mRandom.seed(seed); }
+    uint64_t getBytesRead() const { return mBytesRead; }
+    uint64_t getBytesWritten() const { return mBytesWritten; }
+    size_t getPending() { pump(); return mInput.size(); }
+private:
+    void pump();
+    SimulatedAc&            mAc;
+    ClockFunction           mClock;
+    std::deque<uint8_t>     mInput;     // Bytes already received by ESP side
+    std::mt19937            mRandom;
+    double                  mDropRate;
+    double                  mFlipRate;
+    bool                    mUnplugged;
+    size_t                  mAvailableLimit;
+    uint64_t                mBytesRead;
+    uint64_t                mBytesWritten;
+};
+
+} // namespace host
+
+#endif // SIMULATED_UART_H
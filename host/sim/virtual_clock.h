@@ -0,0 +1,21 @@
+#ifndef VIRTUAL_CLOCK_H
+#define VIRTUAL_CLOCK_H
+
+#include <cstdint>
+
+namespace host {
+
+// Process wide virtual time in ms, HaierClimate::set_clock() takes a plain function
+class VirtualClock
+{
+public:
+    static uint32_t now() { return sTime; }
+    static void set(uint32_t time) { sTime = time; }
+    static void advance(uint32_t ms) { sTime += ms; }
+private:
+    static inline uint32_t sTime = 0;
+};
+
+} // namespace host
+
+#endif // VIRTUAL_CLOCK_H
@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <vector>
+#include "esphome/core/component.h"
+#include "esphome/core/entity_base.h"
+#include "esphome/core/optional.h"
+
+namespace esphome {
+namespace climate {
+
+enum ClimateMode : uint8_t
+{
+    CLIMATE_MODE_OFF = 0,
+    CLIMATE_MODE_HEAT_COOL,
+    CLIMATE_MODE_COOL,
+    CLIMATE_MODE_HEAT,
+    CLIMATE_MODE_FAN_ONLY,
+    CLIMATE_MODE_DRY,
+    CLIMATE_MODE_AUTO,
+};
+
+enum ClimateFanMode : uint8_t
+{
+    CLIMATE_FAN_ON = 0,
+    CLIMATE_FAN_OFF,
+    CLIMATE_FAN_AUTO,
+    CLIMATE_FAN_LOW,
+    CLIMATE_FAN_MEDIUM,
+    CLIMATE_FAN_HIGH,
+    CLIMATE_FAN_MIDDLE,
+    CLIMATE_FAN_FOCUS,
+    CLIMATE_FAN_DIFFUSE,
+};
+
+enum ClimateSwingMode : uint8_t
+{
+    CLIMATE_SWING_OFF = 0,
+    CLIMATE_SWING_BOTH,
+    CLIMATE_SWING_VERTICAL,
+    CLIMATE_SWING_HORIZONTAL,
+};
+
+class ClimateTraits
+{
+public:
+    void set_supported_modes(std::set<ClimateMode> modes) { mModes = std::move(modes); }
+    void set_supported_fan_modes(std::set<ClimateFanMode> modes) { mFanModes = std::move(modes); }
+    void set_supported_swing_modes(std::set<ClimateSwingMode> modes) { mSwingModes = std::move(modes); }
+    void set_visual_min_temperature(float temperature) { mMinTemperature = temperature; }
+    void set_visual_max_temperature(float temperature) { mMaxTemperature = temperature; }
+    void set_visual_temperature_step(float step) { mTemperatureStep = step; }
+    void set_supports_current_temperature(bool supports) { mCurrentTemperature = supports; }
+    bool supports_mode(ClimateMode mode) const { return mModes.count(mode) > 0; }
+    bool supports_fan_mode(ClimateFanMode mode) const { return mFanModes.count(mode) > 0; }
+    bool supports_swing_mode(ClimateSwingMode mode) const { return mSwingModes.count(mode) > 0; }
+    float get_visual_min_temperature() const { return mMinTemperature; }
+    float get_visual_max_temperature() const { return mMaxTemperature; }
+private:
+    std::set<ClimateMode> mModes;
+    std::set<ClimateFanMode> mFanModes;
+    std::set<ClimateSwingMode> mSwingModes;
+    float mMinTemperature = 10.0f;
+    float mMaxTemperature = 30.0f;
+    float mTemperatureStep = 0.1f;
+    bool mCurrentTemperature = false;
+};
+
+class Climate;
+
+class ClimateCall
+{
+public:
+    explicit ClimateCall(Climate* parent) : mParent(parent) {}
+    ClimateCall& set_mode(ClimateMode mode) { mMode = mode; return *this; }
+    ClimateCall& set_fan_mode(ClimateFanMode mode) { mFanMode = mode; return *this; }
+    ClimateCall& set_swing_mode(ClimateSwingMode mode) { mSwingMode = mode; return *this; }
+    ClimateCall& set_target_temperature(float temperature) { mTargetTemperature = temperature; return *this; }
+    // Drops values not supported by traits and calls Climate::control()
+    void perform();
+    const optional<ClimateMode>& get_mode() const { return mMode; }
+    const optional<ClimateFanMode>& get_fan_mode() const { return mFanMode; }
+    const optional<ClimateSwingMode>& get_swing_mode() const { return mSwingMode; }
+    const optional<float>& get_target_temperature() const { return mTargetTemperature; }
+private:
+    Climate* mParent;
+    optional<ClimateMode> mMode;
+    optional<ClimateFanMode> mFanMode;
+    optional<ClimateSwingMode> mSwingMode;
+    optional<float> mTargetTemperature;
+};
+
+class Climate : public EntityBase
+{
+public:
+    virtual ~Climate() = default;
+    ClimateCall make_call() { return ClimateCall(this); }
+    void add_on_state_callback(std::function<void(Climate&)>&& callback) { mStateCallbacks.push_back(std::move(callback)); }
+    void publish_state();
+    ClimateTraits get_traits() { return traits(); }
+
+    ClimateMode mode{CLIMATE_MODE_OFF};
+    optional<ClimateFanMode> fan_mode;
+    ClimateSwingMode swing_mode{CLIMATE_SWING_OFF};
+    float current_temperature{0.0f};
+    float target_temperature{0.0f};
+protected:
+    friend ClimateCall;
+    virtual void control(const ClimateCall& call) = 0;
+    virtual ClimateTraits traits() = 0;
+private:
+    std::vector<std::function<void(Climate&)>> mStateCallbacks;
+};
+
+} // namespace climate
+} // namespace esphome
@@ -0,0 +1,32 @@
+#pragma once
+#include <map>
+#include <string>
+#include "esphome/core/component.h"
+#include "esphome/core/log.h"
+
+namespace esphome {
+namespace logger {
+
+class Logger : public Component
+{
+public:
+    // logger: logs: <tag>: <level>
+    void set_log_level(const std::string& tag, int log_level) { mLogLevels[tag] = log_level; }
+    // logger: level:, or runtime level change
+    void set_log_level(int log_level) { mCurrentLevel = log_level; }
+    int level_for(const char* tag)
+    {
+        auto it = mLogLevels.find(tag);
+        int level = it != mLogLevels.end() ? it->second : ESPHOME_LOG_LEVEL;
+        return level < mCurrentLevel ? level : mCurrentLevel;
+    }
+    void clear_log_levels() { mLogLevels.clear(); mCurrentLevel = ESPHOME_LOG_LEVEL; }
+private:
+    std::map<std::string, int> mLogLevels;
+    int mCurrentLevel = ESPHOME_LOG_LEVEL;
+};
+
+extern Logger* global_logger;
+
+} // namespace logger
+} // namespace esphome
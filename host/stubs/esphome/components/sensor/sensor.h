@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include "esphome/core/entity_base.h"
+
+namespace esphome {
+namespace sensor {
+
+class Sensor : public EntityBase
+{
+public:
+    void publish_state(float state)
+    {
+        this->state = state;
+        mHasState = true;
+        mPublishCount++;
+    }
+    bool has_state() const { return mHasState; }
+    // Host only, number of publish_state() calls
+    uint32_t get_publish_count() const { return mPublishCount; }
+    float state = 0.0f;
+private:
+    bool mHasState = false;
+    uint32_t mPublishCount = 0;
+};
+
+} // namespace sensor
+} // namespace esphome
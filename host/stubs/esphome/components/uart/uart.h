@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace esphome {
+namespace uart {
+
+// Port implementation, host builds provide simulated and pseudo-terminal ports
+class UARTComponent
+{
+public:
+    virtual ~UARTComponent() = default;
+    virtual void write_array(const uint8_t* data, size_t len) = 0;
+    virtual bool peek_byte(uint8_t* data) = 0;
+    virtual bool read_array(uint8_t* data, size_t len) = 0;
+    virtual int available() = 0;
+    virtual void flush() = 0;
+    bool read_byte(uint8_t* data) { return read_array(data, 1); }
+};
+
+class UARTDevice
+{
+public:
+    UARTDevice() = default;
+    UARTDevice(UARTComponent* parent) : parent_(parent) {}
+    void set_uart_parent(UARTComponent* parent) { parent_ = parent; }
+    void write_array(const uint8_t* data, size_t len) { parent_->write_array(data, len); }
+    bool peek_byte(uint8_t* data) { return parent_->peek_byte(data); }
+    bool read_byte(uint8_t* data) { return parent_->read_byte(data); }
+    bool read_array(uint8_t* data, size_t len) { return parent_->read_array(data, len); }
+    int available() { return parent_->available(); }
+    void flush() { parent_->flush(); }
+protected:
+    UARTComponent* parent_ = nullptr;
+};
+
+} // namespace uart
+} // namespace esphome
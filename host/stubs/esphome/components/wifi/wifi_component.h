@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include "esphome/core/component.h"
+
+namespace esphome {
+namespace wifi {
+
+class WiFiComponent : public Component
+{
+public:
+    bool is_connected() { return mConnected; }
+    int8_t wifi_rssi() { return mRssi; }
+    // Host only
+    void set_connected(bool connected) { mConnected = connected; }
+    void set_rssi(int8_t rssi) { mRssi = rssi; }
+private:
+    bool mConnected = true;
+    int8_t mRssi = -60;
+};
+
+extern WiFiComponent* global_wifi_component;
+
+} // namespace wifi
+} // namespace esphome
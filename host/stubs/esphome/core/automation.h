@@ -0,0 +1,14 @@
+#pragma once
+#include "esphome/core/component.h"
+
+namespace esphome {
+
+template<typename... Ts>
+class Action
+{
+public:
+    virtual ~Action() = default;
+    virtual void play(Ts... x) = 0;
+};
+
+} // namespace esphome
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+namespace esphome {
+
+namespace setup_priority {
+extern const float HARDWARE;
+extern const float DATA;
+} // namespace setup_priority
+
+class Component
+{
+public:
+    virtual ~Component() = default;
+    virtual void setup() {}
+    virtual void loop() {}
+    virtual void dump_config() {}
+    virtual float get_setup_priority() const { return 0.0f; }
+    void mark_failed() { mFailed = true; }
+    bool is_failed() const { return mFailed; }
+private:
+    bool mFailed = false;
+};
+
+class PollingComponent : public Component {};
+
+} // namespace esphome
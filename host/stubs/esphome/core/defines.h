@@ -0,0 +1,4 @@
+#pragma once
+// Host build stand-in for the defines.h generated by ESPHome code generation.
+// Component options (HAIER_*) are passed as compile definitions by CMake
+#define USE_LOGGER
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+class EntityBase
+{
+public:
+    void set_name(const std::string& name) { mName = name; mObjectIdHash = fnv1_hash(name); }
+    const std::string& get_name() const { return mName; }
+    uint32_t get_object_id_hash() { return mObjectIdHash; }
+private:
+    std::string mName;
+    uint32_t mObjectIdHash = 0;
+};
+
+} // namespace esphome
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+// Constant data stays in RAM on host
+#define PROGMEM
+
+namespace esphome {
+
+// Monotonic time since process start
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+} // namespace esphome
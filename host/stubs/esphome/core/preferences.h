@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace esphome {
+
+class ESPPreferenceBackend
+{
+public:
+    virtual ~ESPPreferenceBackend() = default;
+    virtual bool save(const uint8_t* data, size_t len) = 0;
+    virtual bool load(uint8_t* data, size_t len) = 0;
+};
+
+class ESPPreferenceObject
+{
+public:
+    ESPPreferenceObject() = default;
+    ESPPreferenceObject(ESPPreferenceBackend* backend) : mBackend(backend) {}
+    template<typename T> bool save(const T* src)
+    {
+        return (mBackend != nullptr) && mBackend->save(reinterpret_cast<const uint8_t*>(src), sizeof(T));
+    }
+    template<typename T> bool load(T* dest)
+    {
+        return (mBackend != nullptr) && mBackend->load(reinterpret_cast<uint8_t*>(dest), sizeof(T));
+    }
+private:
+    ESPPreferenceBackend* mBackend = nullptr;
+};
+
+class ESPPreferences
+{
+public:
+    virtual ~ESPPreferences() = default;
+    virtual ESPPreferenceObject make_preference(size_t length, uint32_t type, bool in_flash) = 0;
+    virtual ESPPreferenceObject make_preference(size_t length, uint32_t type) = 0;
+    virtual bool sync() = 0;
+    template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash)
+    {
+        return make_preference(sizeof(T), type, in_flash);
+    }
+    template<typename T> ESPPreferenceObject make_preference(uint32_t type)
+    {
+        return make_preference(sizeof(T), type);
+    }
+};
+
+extern ESPPreferences* global_preferences;
+
+} // namespace esphome
@@ -0,0 +1,11 @@
+#pragma once
+// Host build stand-in for ESP-IDF FreeRTOS. Tasks are threads that run in
+// lockstep with the test, see host::runTasks() in host_runtime.h
+#include <cstdint>
+
+typedef int         BaseType_t;
+typedef unsigned    UBaseType_t;
+typedef uint32_t    TickType_t;
+
+#define pdPASS      1
+#define pdFAIL      0
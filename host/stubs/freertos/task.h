@@ -0,0 +1,11 @@
+#pragma once
+#include "FreeRTOS.h"
+
+typedef void*   TaskHandle_t;
+typedef void    (*TaskFunction_t)(void* parameter);
+
+// Task starts running on the next host::runTasks(), stack size and priority are ignored
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stackDepth, void* parameter,
+                       UBaseType_t priority, TaskHandle_t* handle);
+// In a task: returns after the next host::runTasks(), every call is one tick whatever the argument is
+void vTaskDelay(TickType_t ticks);
@@ -0,0 +1,72 @@
+#ifndef HAIER_FIXTURE_H
+#define HAIER_FIXTURE_H
+
+#include <gtest/gtest.h>
+#include "host_runtime.h"
+#include "simulated_ac.h"
+#include "simulated_uart.h"
+#include "virtual_clock.h"
+#include "haier_climate.h"
+
+// One HaierClimate talking to a SimulatedAc over in-memory UART, in virtual time
+class HaierFixture : public ::testing::Test
+{
+protected:
+    static constexpr uint32_t START_TIME = 1000;
+
+    HaierFixture() : mUart(mAc, host::VirtualClock::now), mClimate(&mUart), mPublishes(0), mLastPublishTime(0)
+    {
+        host::resetRuntime();
+        host::VirtualClock::set(START_TIME);
+        mClimate.set_clock(host::VirtualClock::now);
+        mClimate.set_name("Haier AC");
+        mClimate.add_on_state_callback([this](esphome::climate::Climate&)
+        {
+            mPublishes++;
+            mLastPublishTime = host::VirtualClock::now();
+        });
+    }
+    void start()
+    {
+        mSetupTime = host::VirtualClock::now();
+        mClimate.setup();
+    }
+    ~HaierFixture()
+    {
+        host::stopTasks();
+    }
+    // One loop() call per ms, RX task (if any) runs once before it
+    void run(uint32_t ms)
+    {
+        for (uint32_t i = 0; i < ms; ++i)
+        {
+            host::VirtualClock::advance(1);
+            host::runTasks();
+            mClimate.loop();
+        }
+    }
+    template<typename P>
+    bool runUntil(P predicate, uint32_t timeoutMs)
+    {
+        for (uint32_t i = 0; i < timeoutMs; ++i)
+        {
+            if (predicate())
+                return true;
+            run(1);
+        }
+        return predicate();
+    }
+    bool waitFirstStatus(uint32_t timeoutMs = 10000)
+    {
+        return runUntil([this]() { return mPublishes > 0; }, timeoutMs);
+    }
+
+    host::SimulatedAc           mAc;
+    host::SimulatedUart         mUart;
+    esphome::haier::HaierClimate mClimate;
+    uint32_t                    mSetupTime;
+    uint32_t                    mPublishes;
+    uint32_t                    mLastPublishTime;
+};
+
+#endif // HAIER_FIXTURE_H
@@ -0,0 +1,24 @@
+#ifndef HAIER_UNIT_H
+#define HAIER_UNIT_H
+
+#include "simulated_ac.h"
+#include "simulated_uart.h"
+#include "virtual_clock.h"
+#include "haier_climate.h"
+
+// HaierClimate with its own simulated AC, several of them can share one node (and virtual clock)
+struct HaierUnit
+{
+    explicit HaierUnit(const char* name) : uart(ac, host::VirtualClock::now), climate(&uart), publishes(0)
+    {
+        climate.set_clock(host::VirtualClock::now);
+        climate.set_name(name);
+        climate.add_on_state_callback([this](esphome::climate::Climate&) { publishes++; });
+    }
+    host::SimulatedAc               ac;
+    host::SimulatedUart             uart;
+    esphome::haier::HaierClimate    climate;
+    uint32_t                        publishes;
+};
+
+#endif // HAIER_UNIT_H
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "capture_replay.h"
+#include "haier_fixture.h"
+
+using namespace esphome::climate;
+
+namespace {
+
+class CaptureTest : public HaierFixture
+{
+protected:
+    // Log lines of dump_capture()
+    std::vector<std::string> dump(bool binary)
+    {
+        std::vector<std::string> lines;
+        host::setLogCallback([&lines](int, const char*, const char* message) { lines.push_back(message); });
+        mClimate.dump_capture(binary);
+        host::setLogCallback(host::LogCallback());
+        return lines;
+    }
+    static std::vector<host::CaptureRecord> parse(const std::vector<std::string>& lines)
+    {
+        host::CaptureParser parser;
+        for (const std::string& line : lines)
+            EXPECT_TRUE(parser.addLine(line)) << line;
+        EXPECT_TRUE(parser.finish());
+        return parser.getRecords();
+    }
+    // Status changes made on AC side and by control
+    void runTraffic()
+    {
+        start();
+        ASSERT_TRUE(waitFirstStatus());
+        run(20000);
+        mAc.setPower(true);
+        mAc.setMode(0x04);
+        run(20000);
+        mAc.setRoomTemperature(26);
+        run(20000);
+    }
+};
+
+TEST_F(CaptureTest, BinaryDumpHasSameRecordsAsHexDump)
+{
+    runTraffic();
+    std::vector<host::CaptureRecord> hex = parse(dump(false));
+    std::vector<host::CaptureRecord> binary = parse(dump(true));
+    ASSERT_GT(hex.size(), 10u);
+    ASSERT_EQ(hex.size(), binary.size());
+    for (size_t i = 0; i < hex.size(); ++i)
+    {
+        EXPECT_EQ(hex[i].sent, binary[i].sent);
+        EXPECT_EQ(hex[i].timestamp, binary[i].timestamp);
+        EXPECT_EQ(hex[i].data, binary[i].data);
+    }
+}
+
+TEST_F(CaptureTest, BinaryDumpIsSmallerThanHexDump)
+{
+    runTraffic();
+    size_t hexSize = 0;
+    size_t binarySize = 0;
+    for (const std::string& line : dump(false))
+        hexSize += line.size();
+    for (const std::string& line : dump(true))
+        binarySize += line.size();
+    // Hex takes 3 characters per byte plus record prefix, base64 takes 4 per 3 bytes
+    EXPECT_LT(binarySize * 2, hexSize);
+}
+
+TEST_F(CaptureTest, ReplayReachesSameState)
+{
+    runTraffic();
+    std::vector<host::CaptureRecord> records = parse(dump(true));
+    host::ReplayUart uart;
+    esphome::haier::HaierClimate replayed(&uart);
+    replayed.set_name("Replay");
+    host::ReplayResult result = host::replayCapture(records, uart, replayed);
+    EXPECT_EQ(result.protocol.rxFrames, mClimate.get_protocol_statistics().rxFrames);
+    EXPECT_EQ(result.decoder.checksumErrors, 0u);
+    EXPECT_EQ(result.decoder.wrongSizeErrors, 0u);
+    EXPECT_GE(result.publish.published, 3u);
+    EXPECT_EQ(replayed.mode, CLIMATE_MODE_DRY);
+    EXPECT_EQ(replayed.mode, mClimate.mode);
+    EXPECT_EQ(replayed.target_temperature, mClimate.target_temperature);
+    EXPECT_EQ(replayed.current_temperature, mClimate.current_temperature);
+    EXPECT_EQ(replayed.fan_mode, mClimate.fan_mode);
+    EXPECT_EQ(replayed.swing_mode, mClimate.swing_mode);
+}
+
+TEST_F(CaptureTest, ReplayCountsBrokenFrames)
+{
+    mUart.setSeed(1);
+    mUart.setFlipRate(0.002);
+    runTraffic();
+    std::vector<host::CaptureRecord> records = parse(dump(true));
+    host::ReplayUart uart;
+    esphome::haier::HaierClimate replayed(&uart);
+    replayed.set_name("Replay");
+    host::ReplayResult result = host::replayCapture(records, uart, replayed);
+    const esphome::haier::HaierFrameDecoder::Statistics& live = mClimate.get_decoder_statistics();
+    ASSERT_GT(live.checksumErrors + live.crcErrors, 0u);
+    EXPECT_EQ(result.decoder.checksumErrors + result.decoder.crcErrors, live.checksumErrors + live.crcErrors);
+    EXPECT_EQ(result.protocol.rxFrames, mClimate.get_protocol_statistics().rxFrames);
+}
+
+} // namespace
@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include "haier_fixture.h"
+
+namespace {
+
+// Timing with millis() after 24.8 days (2^31 ms) and around its overflow after 49.7 days
+class ClockTest : public HaierFixture
+{
+protected:
+    uint32_t countStatusRequests(uint32_t ms)
+    {
+        uint32_t requests = mAc.getStatistics().statusRequests;
+        run(ms);
+        return mAc.getStatistics().statusRequests - requests;
+    }
+};
+
+TEST_F(ClockTest, ProtocolStartsAfterHalfOfClockRange)
+{
+    host::VirtualClock::set(0x80000000);
+    start();
+    ASSERT_TRUE(waitFirstStatus(2500));
+}
+
+TEST_F(ClockTest, ProtocolStartsWhenClockOverflowsDuringWarmUp)
+{
+    host::VirtualClock::set(0xFFFFFFFF - 1000);
+    start();
+    ASSERT_TRUE(waitFirstStatus(2500));
+    EXPECT_EQ(mClimate.get_protocol_statistics().firstStatusTime, mLastPublishTime - mSetupTime);
+}
+
+TEST_F(ClockTest, NoFastPollingWithoutWindowAfterHalfOfClockRange)
+{
+    mClimate.set_fast_polling_window(0);
+    host::VirtualClock::set(0x80000000);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    mAc.setRoomTemperature(26);
+    // 5 s interval
+    EXPECT_NEAR(countStatusRequests(30000), 6, 1);
+}
+
+TEST_F(ClockTest, FastPollingWindowEndsAcrossClockOverflow)
+{
+    host::VirtualClock::set(0xFFFFFFFF - 20000);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    run(10000);
+    // Control opens 10 s window with 1 s interval, clock overflows inside it
+    mClimate.make_call().set_target_temperature(25).perform();
+    run(1000);
+    EXPECT_NEAR(countStatusRequests(9000), 9, 1);
+    run(1000);
+    EXPECT_NEAR(countStatusRequests(30000), 6, 1);
+}
+
+TEST_F(ClockTest, NoFastPollingWhenWindowEndIsHalfOfClockRangeAgo)
+{
+    mClimate.set_answer_timeout(2000);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    mClimate.make_call().set_target_temperature(25).perform();
+    run(20000);
+    // loop() keeps running while time goes on, in coarse steps to keep the test fast
+    for (uint32_t elapsed = 0; elapsed < 0x80000000; elapsed += 1000)
+    {
+        host::VirtualClock::advance(1000);
+        mClimate.loop();
+    }
+    run(20000);
+    EXPECT_NEAR(countStatusRequests(30000), 6, 1);
+}
+
+} // namespace
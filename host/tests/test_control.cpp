@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include "haier_fixture.h"
+
+using namespace esphome::climate;
+
+namespace {
+
+class ControlTest : public HaierFixture
+{
+protected:
+    void SetUp() override
+    {
+        mAc.setAnswerDelay(200);
+        start();
+        ASSERT_TRUE(waitFirstStatus());
+    }
+    bool waitControlSent(uint32_t count)
+    {
+        return runUntil([this, count]() { return mAc.getStatistics().controlCommands >= count; }, 5000);
+    }
+};
+
+TEST_F(ControlTest, CallsAreMergedIntoOneControlPacket)
+{
+    // Slider dragged while waiting for status answer
+    mClimate.make_call().set_mode(CLIMATE_MODE_COOL).perform();
+    mClimate.make_call().set_target_temperature(20).perform();
+    mClimate.make_call().set_target_temperature(19).perform();
+    mClimate.make_call().set_fan_mode(CLIMATE_FAN_LOW).perform();
+    run(3000);
+    EXPECT_EQ(mAc.getStatistics().controlCommands, 1u);
+    EXPECT_TRUE(mAc.isPowerOn());
+    EXPECT_EQ(mAc.getSetPoint(), 19);
+    EXPECT_EQ(mAc.getFanSpeed(), 0x02);
+}
+
+TEST_F(ControlTest, DisplayChangeWhileControlIsInFlightIsSent)
+{
+    mClimate.make_call().set_mode(CLIMATE_MODE_HEAT).perform();
+    ASSERT_TRUE(waitControlSent(1));
+    // Control packet with display on is already on the line, its answer will match it
+    mClimate.set_display_state(false);
+    run(5000);
+    EXPECT_EQ(mAc.getMode(), 0x02);
+    EXPECT_TRUE(mAc.isDisplayOff());
+    EXPECT_FALSE(mClimate.get_display_state());
+}
+
+TEST_F(ControlTest, ControlChangeWhileControlIsInFlightIsSent)
+{
+    mClimate.make_call().set_mode(CLIMATE_MODE_HEAT).perform();
+    ASSERT_TRUE(waitControlSent(1));
+    mClimate.make_call().set_target_temperature(27).perform();
+    run(5000);
+    EXPECT_EQ(mAc.getMode(), 0x02);
+    EXPECT_EQ(mAc.getSetPoint(), 27);
+}
+
+TEST_F(ControlTest, DisplayOnlyChangeIsSent)
+{
+    mClimate.set_display_state(false);
+    run(3000);
+    EXPECT_TRUE(mAc.isDisplayOff());
+    mClimate.set_display_state(true);
+    run(3000);
+    EXPECT_FALSE(mAc.isDisplayOff());
+    EXPECT_EQ(mAc.getStatistics().controlCommands, 2u);
+}
+
+TEST_F(ControlTest, NotAppliedControlIsRetriedLimitedTimes)
+{
+    mAc.setIgnoreControl(true);
+    mClimate.make_call().set_mode(CLIMATE_MODE_COOL).perform();
+    run(30000);
+    // First attempt and 3 retries
+    EXPECT_EQ(mAc.getStatistics().controlCommands, 4u);
+    EXPECT_FALSE(mAc.isPowerOn());
+    EXPECT_EQ(mClimate.mode, CLIMATE_MODE_OFF);
+}
+
+} // namespace
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "crc_variants.h"
+#include "haier_crc.h"
+#include "haier_fixture.h"
+
+using esphome::haier::crc16;
+using esphome::haier::crc16Update;
+
+namespace {
+
+TEST(CrcTest, MatchesCrc16Arc)
+{
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    EXPECT_EQ(crc16(check, sizeof(check)), 0xBB3D);
+    EXPECT_EQ(host::crc16Nibble(check, sizeof(check)), 0xBB3D);
+    EXPECT_EQ(host::crc16Bitwise(check, sizeof(check)), 0xBB3D);
+}
+
+TEST(CrcTest, TablesMatchBitwiseImplementation)
+{
+    std::mt19937 random(7);
+    uint8_t message[64];
+    for (int round = 0; round < 1000; ++round)
+    {
+        size_t size = random() % sizeof(message) + 1;
+        for (size_t i = 0; i < size; ++i)
+            message[i] = random() & 0xFF;
+        uint16_t expected = host::crc16Bitwise(message, size);
+        ASSERT_EQ(crc16(message, size), expected);
+        ASSERT_EQ(host::crc16Nibble(message, size), expected);
+    }
+}
+
+TEST(CrcTest, IncrementalUpdateMatchesWholeMessage)
+{
+    const uint8_t message[] = { 0x25, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x6D, 0x01 };
+    uint16_t crc = 0;
+    for (uint8_t value : message)
+        crc = crc16Update(crc, value);
+    EXPECT_EQ(crc, crc16(message, sizeof(message)));
+}
+
+class CrcVerificationTest : public HaierFixture {};
+
+TEST_F(CrcVerificationTest, FramesWithValidCrcAreAccepted)
+{
+    mAc.setSendCrc(true);
+    mClimate.set_verify_crc(true);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    run(20000);
+    EXPECT_EQ(mClimate.get_decoder_statistics().crcErrors, 0u);
+    EXPECT_EQ(mClimate.get_decoder_statistics().checksumErrors, 0u);
+}
+
+TEST_F(CrcVerificationTest, FrameWithWrongCrcIsRejected)
+{
+    mClimate.set_verify_crc(true);
+    start();
+    run(2000);
+    // Checksum is right, CRC is not
+    uint8_t frame[2 + host::SimulatedAc::STATUS_SIZE + 3];
+    frame[0] = 0xFF;
+    frame[1] = 0xFF;
+    memcpy(frame + 2, mAc.getStatus(), host::SimulatedAc::STATUS_SIZE);
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < host::SimulatedAc::STATUS_SIZE; ++i)
+        checksum += frame[2 + i];
+    frame[2 + host::SimulatedAc::STATUS_SIZE] = checksum;
+    uint16_t crc = crc16(frame + 2, host::SimulatedAc::STATUS_SIZE) ^ 0x0100;
+    frame[3 + host::SimulatedAc::STATUS_SIZE] = crc >> 8;
+    frame[4 + host::SimulatedAc::STATUS_SIZE] = crc & 0xFF;
+    mAc.setSilent(true);
+    mUart.injectBytes(frame, sizeof(frame));
+    run(100);
+    EXPECT_EQ(mClimate.get_decoder_statistics().crcErrors, 1u);
+    EXPECT_EQ(mPublishes, 0u);
+}
+
+} // namespace
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "haier_fixture.h"
+
+namespace {
+
+// UART flooded with noise (floating RX pin, stuck line). Every loop() call is timed
+// in real time, micros() used by the time budget is real time on host too
+class FloodTest : public HaierFixture
+{
+protected:
+    static constexpr size_t FLOOD_SIZE = 1024 * 1024;
+
+    const esphome::haier::HaierClimate::ProtocolStatistics& statistics() const
+    {
+        return mClimate.get_protocol_statistics();
+    }
+    void SetUp() override
+    {
+        start();
+        ASSERT_TRUE(waitFirstStatus());
+        run(1000);
+    }
+    // Runs until flood is consumed, returns loop() durations in us
+    std::vector<uint32_t> runFlood(uint32_t& maxBytesPerLoop)
+    {
+        std::vector<uint32_t> durations;
+        maxBytesPerLoop = 0;
+        mUart.injectNoise(FLOOD_SIZE);
+        while ((mUart.getPending() > 0) && (durations.size() < 1000000))
+        {
+            uint32_t bytes = statistics().rxBytes;
+            host::VirtualClock::advance(1);
+            auto begin = std::chrono::steady_clock::now();
+            mClimate.loop();
+            auto end = std::chrono::steady_clock::now();
+            durations.push_back(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count());
+            maxBytesPerLoop = std::max(maxBytesPerLoop, statistics().rxBytes - bytes);
+        }
+        std::sort(durations.begin(), durations.end());
+        return durations;
+    }
+    static uint32_t percentile(const std::vector<uint32_t>& sorted, double p)
+    {
+        return sorted[(size_t)((sorted.size() - 1) * p)];
+    }
+    // Flood is over, component still follows the AC
+    void expectCommunication()
+    {
+        uint32_t publishes = mPublishes;
+        mAc.setRoomTemperature(29);
+        EXPECT_TRUE(runUntil([this]() { return mClimate.current_temperature == 29.0f; }, 30000));
+        EXPECT_GT(mPublishes, publishes);
+    }
+};
+
+TEST_F(FloodTest, ByteBudgetBoundsEveryLoop)
+{
+    const uint32_t BUDGET = 256;
+    mClimate.set_rx_byte_budget(BUDGET);
+    uint32_t overloads = statistics().rxOverloads;
+    uint32_t maxBytes;
+    std::vector<uint32_t> durations = runFlood(maxBytes);
+    ASSERT_FALSE(durations.empty());
+    EXPECT_EQ(mUart.getPending(), 0u);
+    EXPECT_LE(maxBytes, BUDGET);
+    EXPECT_GE(durations.size(), FLOOD_SIZE / BUDGET);
+    EXPECT_GT(statistics().rxOverloads - overloads, durations.size() / 2);
+    // Few hundred bytes take microseconds, limits leave room for scheduler on a busy host
+    EXPECT_LT(percentile(durations, 0.99), 1000u);
+    printf("%zu loops, max %u bytes per loop, loop time median %u us, p99 %u us, max %u us\n",
+           durations.size(), maxBytes, percentile(durations, 0.5), percentile(durations, 0.99), durations.back());
+    expectCommunication();
+}
+
+// Byte budget too large for the flood, time budget stops every loop. Host decodes
+// about 100 times faster than ESP8266, budget is scaled down to get many loops
+TEST_F(FloodTest, TimeBudgetBoundsEveryLoop)
+{
+    const uint32_t BUDGET_US = 100;
+    mClimate.set_rx_byte_budget(FLOOD_SIZE);
+    mClimate.set_rx_time_budget(BUDGET_US);
+    uint32_t overloads = statistics().rxOverloads;
+    uint32_t maxBytes;
+    std::vector<uint32_t> durations = runFlood(maxBytes);
+    ASSERT_FALSE(durations.empty());
+    EXPECT_EQ(mUart.getPending(), 0u);
+    EXPECT_LT(maxBytes, FLOOD_SIZE);
+    EXPECT_GT(durations.size(), 10u);
+    EXPECT_GE(statistics().rxOverloads - overloads, durations.size() - 1);
+    // Budget is checked after every decoder buffer, one buffer more can be processed
+    EXPECT_LT(percentile(durations, 0.99), BUDGET_US + 900u);
+    printf("%zu loops, max %u bytes per loop, loop time median %u us, p99 %u us, max %u us\n",
+           durations.size(), maxBytes, percentile(durations, 0.5), percentile(durations, 0.99), durations.back());
+    expectCommunication();
+}
+
+// Without budgets the whole flood goes through one loop() call, for comparison with the tests above
+TEST_F(FloodTest, UnboundedLoopForComparison)
+{
+    mClimate.set_rx_byte_budget(FLOOD_SIZE);
+    mClimate.set_rx_time_budget(UINT32_MAX);
+    uint32_t maxBytes;
+    std::vector<uint32_t> durations = runFlood(maxBytes);
+    ASSERT_FALSE(durations.empty());
+    EXPECT_EQ(durations.size(), 1u);
+    printf("%zu loops, max %u bytes per loop, loop time max %u us\n", durations.size(), maxBytes, durations.back());
+    expectCommunication();
+}
+
+} // namespace
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "haier_frame_queue.h"
+
+using esphome::haier::HaierFrameQueue;
+using esphome::haier::HaierProtocol;
+
+namespace {
+
+// Frame of given size with every byte set to value
+void fill(uint8_t* data, uint8_t size, uint8_t value)
+{
+    memset(data, value, size);
+}
+
+TEST(FrameQueueTest, FramesComeOutInOrder)
+{
+    HaierFrameQueue<4> queue;
+    uint8_t size;
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(queue.front(size), nullptr);
+    uint8_t data[HaierProtocol::MAX_FRAME_SIZE];
+    for (uint8_t i = 1; i <= 3; ++i)
+    {
+        fill(data, 10 + i, i);
+        ASSERT_TRUE(queue.push(data, 10 + i));
+    }
+    for (uint8_t i = 1; i <= 3; ++i)
+    {
+        const uint8_t* frame = queue.front(size);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(size, 10 + i);
+        EXPECT_EQ(frame[0], i);
+        EXPECT_EQ(frame[size - 1], i);
+        queue.pop();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(FrameQueueTest, PushFailsWhenFull)
+{
+    HaierFrameQueue<4> queue;
+    uint8_t data[HaierProtocol::MAX_FRAME_SIZE] = {};
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(queue.push(data, 8));
+    EXPECT_FALSE(queue.push(data, 8));
+    queue.pop();
+    EXPECT_TRUE(queue.push(data, 8));
+}
+
+TEST(FrameQueueTest, SlotsAreReusedAfterWrap)
+{
+    HaierFrameQueue<2> queue;
+    uint8_t data[HaierProtocol::MAX_FRAME_SIZE];
+    uint8_t size;
+    for (int i = 0; i < 1000; ++i)
+    {
+        fill(data, 20, (uint8_t)i);
+        ASSERT_TRUE(queue.push(data, 20));
+        const uint8_t* frame = queue.front(size);
+        ASSERT_NE(frame, nullptr);
+        EXPECT_EQ(frame[19], (uint8_t)i);
+        queue.pop();
+    }
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(FrameQueueTest, OversizedFrameIsTruncated)
+{
+    HaierFrameQueue<2> queue;
+    uint8_t data[HaierProtocol::MAX_FRAME_SIZE + 10] = {};
+    ASSERT_TRUE(queue.push(data, sizeof(data)));
+    uint8_t size;
+    ASSERT_NE(queue.front(size), nullptr);
+    EXPECT_EQ(size, HaierProtocol::MAX_FRAME_SIZE);
+}
+
+// RX task and loop() on different threads. Every frame carries its number in every byte
+// and has size depending on the number, consumer checks order and content of each one
+TEST(FrameQueueTest, ProducerAndConsumerThreads)
+{
+    const uint32_t FRAMES = 200000;
+    HaierFrameQueue<4> queue;
+    std::atomic<uint32_t> full(0);
+    std::thread producer([&]()
+    {
+        uint8_t data[HaierProtocol::MAX_FRAME_SIZE];
+        for (uint32_t i = 0; i < FRAMES; ++i)
+        {
+            uint8_t size = 8 + i % (HaierProtocol::MAX_FRAME_SIZE - 8);
+            fill(data, size, (uint8_t)i);
+            while (!queue.push(data, size))
+            {
+                full++;
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t broken = 0;
+    uint32_t received = 0;
+    while (received < FRAMES)
+    {
+        uint8_t size;
+        const uint8_t* frame = queue.front(size);
+        if (frame == nullptr)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        uint8_t value = (uint8_t)received;
+        bool valid = size == 8 + received % (HaierProtocol::MAX_FRAME_SIZE - 8);
+        for (uint8_t i = 0; valid && (i < size); ++i)
+            valid = frame[i] == value;
+        if (!valid)
+            broken++;
+        queue.pop();
+        received++;
+    }
+    producer.join();
+    EXPECT_EQ(broken, 0u);
+    EXPECT_TRUE(queue.empty());
+    printf("%u frames, producer found queue full %u times\n", FRAMES, full.load());
+}
+
+} // namespace
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include "host_runtime.h"
+#include "haier_unit.h"
+
+using namespace esphome::climate;
+
+namespace {
+
+class InstancesTest : public ::testing::Test
+{
+protected:
+    InstancesTest()
+    {
+        host::resetRuntime();
+        host::VirtualClock::set(1000);
+    }
+    void run(uint32_t ms)
+    {
+        for (uint32_t i = 0; i < ms; ++i)
+        {
+            host::VirtualClock::advance(1);
+            for (auto& unit : mUnits)
+                unit->climate.loop();
+        }
+    }
+    std::vector<std::unique_ptr<HaierUnit>> mUnits;
+};
+
+TEST_F(InstancesTest, UnitsDontShareDecoderState)
+{
+    const char* names[] = { "Living room", "Bedroom", "Office", "Kitchen" };
+    for (int i = 0; i < 4; ++i)
+    {
+        mUnits.emplace_back(new HaierUnit(names[i]));
+        HaierUnit& unit = *mUnits.back();
+        unit.ac.setRoomTemperature(20 + i);
+        unit.ac.setSetPoint(16 + i);
+        // Partial frames of all units are in decoders at the same time
+        unit.uart.setAvailableLimit(3 + i);
+        unit.ac.setAnswerDelay(5 + i);
+        unit.ac.setUnsolicitedInterval(97 + i * 13);
+        unit.climate.setup();
+    }
+    run(30000);
+    for (int i = 0; i < 4; ++i)
+    {
+        HaierUnit& unit = *mUnits[i];
+        SCOPED_TRACE(names[i]);
+        EXPECT_GT(unit.publishes, 0u);
+        EXPECT_EQ(unit.climate.current_temperature, 20.0f + i);
+        EXPECT_EQ(unit.climate.target_temperature, 16.0f + i);
+        const esphome::haier::HaierFrameDecoder::Statistics& statistics = unit.climate.get_decoder_statistics();
+        EXPECT_EQ(statistics.checksumErrors, 0u);
+        EXPECT_EQ(statistics.wrongSizeErrors, 0u);
+        EXPECT_EQ(statistics.droppedFrames, 0u);
+    }
+}
+
+TEST_F(InstancesTest, ControlGoesOnlyToItsUnit)
+{
+    mUnits.emplace_back(new HaierUnit("First"));
+    mUnits.emplace_back(new HaierUnit("Second"));
+    for (auto& unit : mUnits)
+        unit->climate.setup();
+    run(3000);
+    mUnits[1]->climate.make_call().set_mode(CLIMATE_MODE_COOL).set_target_temperature(18).perform();
+    run(2000);
+    EXPECT_FALSE(mUnits[0]->ac.isPowerOn());
+    EXPECT_EQ(mUnits[0]->ac.getStatistics().controlCommands, 0u);
+    EXPECT_TRUE(mUnits[1]->ac.isPowerOn());
+    EXPECT_EQ(mUnits[1]->ac.getSetPoint(), 18);
+}
+
+} // namespace
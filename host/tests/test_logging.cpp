@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include "esphome/components/logger/logger.h"
+#include "haier_fixture.h"
+
+namespace {
+
+class LoggingTest : public HaierFixture {};
+
+TEST_F(LoggingTest, FramesAreFormattedAtDebugLevel)
+{
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    // Status request and its answer
+    EXPECT_GT(mClimate.get_log_statistics().bytesFormatted, 0u);
+}
+
+TEST_F(LoggingTest, NothingIsFormattedWhenTagLevelIsLowered)
+{
+    // logger: logs: Haier: WARN
+    esphome::logger::global_logger->set_log_level("Haier", ESPHOME_LOG_LEVEL_WARN);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    run(30000);
+    const esphome::haier::HaierClimate::LogStatistics& statistics = mClimate.get_log_statistics();
+    EXPECT_EQ(statistics.bytesFormatted, 0u);
+    EXPECT_GT(statistics.bytesSuppressed, 0u);
+    EXPECT_EQ(host::getLogLines(ESPHOME_LOG_LEVEL_DEBUG), 0u);
+}
+
+TEST_F(LoggingTest, NothingIsFormattedWhenLevelIsLoweredAtRuntime)
+{
+    esphome::logger::global_logger->set_log_level(ESPHOME_LOG_LEVEL_INFO);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    run(30000);
+    EXPECT_EQ(mClimate.get_log_statistics().bytesFormatted, 0u);
+}
+
+TEST_F(LoggingTest, RepeatedStatusIsLoggedOnlyOnce)
+{
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    uint32_t formatted = mClimate.get_log_statistics().bytesFormatted;
+    // Identical answers, only requests are logged
+    run(50000);
+    const esphome::haier::HaierClimate::LogStatistics& statistics = mClimate.get_log_statistics();
+    uint32_t answers = mAc.getStatistics().framesSent - 1;
+    EXPECT_GE(statistics.bytesSuppressed, (answers - 1) * host::SimulatedAc::STATUS_SIZE);
+    EXPECT_LT(statistics.bytesFormatted - formatted, answers * 13 + 2 * 40u);
+}
+
+} // namespace
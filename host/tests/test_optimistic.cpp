@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "haier_fixture.h"
+
+using namespace esphome::climate;
+
+namespace {
+
+class OptimisticTest : public HaierFixture
+{
+protected:
+    void SetUp() override
+    {
+        mClimate.set_optimistic(true);
+        mAc.setAnswerDelay(200);
+        start();
+        ASSERT_TRUE(waitFirstStatus());
+    }
+};
+
+TEST_F(OptimisticTest, RequestedStateIsPublishedRightAway)
+{
+    uint32_t publishes = mPublishes;
+    mClimate.make_call().set_mode(CLIMATE_MODE_HEAT).set_target_temperature(25).perform();
+    EXPECT_EQ(mPublishes, publishes + 1);
+    EXPECT_EQ(mClimate.mode, CLIMATE_MODE_HEAT);
+    EXPECT_EQ(mClimate.target_temperature, 25.0f);
+    run(3000);
+    const esphome::haier::HaierClimate::OptimisticStatistics& statistics = mClimate.get_optimistic_statistics();
+    EXPECT_EQ(statistics.confirmed, 1u);
+    EXPECT_EQ(statistics.rolledBack, 0u);
+    EXPECT_GE(statistics.lastLatency, 200u);
+}
+
+TEST_F(OptimisticTest, RejectedStateIsRolledBack)
+{
+    mAc.setIgnoreControl(true);
+    mClimate.make_call().set_mode(CLIMATE_MODE_HEAT).perform();
+    run(30000);
+    EXPECT_EQ(mClimate.mode, CLIMATE_MODE_OFF);
+    EXPECT_EQ(mClimate.get_optimistic_statistics().rolledBack, 1u);
+}
+
+TEST_F(OptimisticTest, HeldAnswersAreNotCountedAsSuppressed)
+{
+    // Status request is on the line when control is requested
+    uint32_t requests = mAc.getStatistics().statusRequests;
+    ASSERT_TRUE(runUntil([this, requests]() { return mAc.getStatistics().statusRequests > requests; }, 10000));
+    esphome::haier::HaierClimate::PublishStatistics before = mClimate.get_publish_statistics();
+    mClimate.make_call().set_mode(CLIMATE_MODE_HEAT).perform();
+    // Answer to the status request comes before control is sent
+    run(300);
+    const esphome::haier::HaierClimate::PublishStatistics& after = mClimate.get_publish_statistics();
+    EXPECT_EQ(after.held, before.held + 1);
+    EXPECT_EQ(after.suppressed, before.suppressed);
+    EXPECT_EQ(mClimate.mode, CLIMATE_MODE_HEAT);
+}
+
+} // namespace
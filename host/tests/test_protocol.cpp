@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "esphome/core/hal.h"
+#include "pty_uart.h"
+#include "haier_fixture.h"
+
+using namespace esphome::climate;
+using host::SimulatedAc;
+
+namespace {
+
+class ProtocolTest : public HaierFixture {};
+
+TEST_F(ProtocolTest, FirstStatusIsPublished)
+{
+    mAc.setRoomTemperature(27);
+    mAc.setSetPoint(22);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    EXPECT_EQ(mClimate.mode, CLIMATE_MODE_OFF);
+    EXPECT_EQ(mClimate.target_temperature, 22.0f);
+    EXPECT_EQ(mClimate.current_temperature, 27.0f);
+    ASSERT_TRUE(mClimate.fan_mode.has_value());
+    EXPECT_EQ(*mClimate.fan_mode, CLIMATE_FAN_AUTO);
+    EXPECT_EQ(mAc.getStatistics().statusRequests, 1u);
+}
+
+TEST_F(ProtocolTest, ControlIsAppliedByAc)
+{
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    mClimate.make_call().set_mode(CLIMATE_MODE_HEAT).set_target_temperature(21).set_fan_mode(CLIMATE_FAN_HIGH).perform();
+    ASSERT_TRUE(runUntil([this]() { return mAc.getStatistics().controlCommands > 0; }, 1000));
+    run(500);
+    EXPECT_TRUE(mAc.isPowerOn());
+    EXPECT_EQ(mAc.getMode(), 0x02);
+    EXPECT_EQ(mAc.getSetPoint(), 21);
+    EXPECT_EQ(mAc.getFanSpeed(), 0x00);
+    EXPECT_EQ(mClimate.mode, CLIMATE_MODE_HEAT);
+    EXPECT_EQ(mClimate.target_temperature, 21.0f);
+    EXPECT_EQ(*mClimate.fan_mode, CLIMATE_FAN_HIGH);
+    // Acknowledged by the status answer, so nothing is resent
+    run(10000);
+    EXPECT_EQ(mAc.getStatistics().controlCommands, 1u);
+}
+
+TEST_F(ProtocolTest, ControlEqualToCurrentStateIsNotSent)
+{
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    mClimate.make_call().set_mode(CLIMATE_MODE_OFF).perform();
+    run(2000);
+    EXPECT_EQ(mAc.getStatistics().controlCommands, 0u);
+}
+
+TEST_F(ProtocolTest, StatusIsPolledWithConfiguredInterval)
+{
+    mClimate.set_status_request_interval(5000);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    uint32_t requests = mAc.getStatistics().statusRequests;
+    run(60000);
+    EXPECT_NEAR(mAc.getStatistics().statusRequests - requests, 12, 1);
+}
+
+TEST_F(ProtocolTest, StatusChangedByRemoteIsPublished)
+{
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    mAc.setPower(true);
+    mAc.setMode(0x04);
+    ASSERT_TRUE(runUntil([this]() { return mClimate.mode == CLIMATE_MODE_DRY; }, 10000));
+}
+
+TEST_F(ProtocolTest, ProcessingTimeDoesNotIncludePublishing)
+{
+    // Slow state subscriber, like API or MQTT sending the new state
+    mClimate.add_on_state_callback([](esphome::climate::Climate&) { esphome::delayMicroseconds(5000); });
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    const esphome::haier::HaierClimate::ProtocolStatistics& statistics = mClimate.get_protocol_statistics();
+    EXPECT_GE(statistics.publishingTime, 5000u);
+    EXPECT_LT(statistics.rxProcessingTime, 5000u);
+}
+
+// Same protocol over a pseudo-terminal in real time, AC runs in its own thread
+TEST(PtyTest, ClimateTalksToSimulatedAcOverPseudoTerminal)
+{
+    host::resetRuntime();
+    SimulatedAc ac;
+    host::PtyAc pty(ac);
+    ASSERT_TRUE(pty.open());
+    pty.start();
+    host::SerialUart uart;
+    ASSERT_TRUE(uart.open(pty.getSlavePath()));
+    esphome::haier::HaierClimate climate(&uart);
+    climate.set_name("Haier AC");
+    climate.set_warm_up_time(10);
+    uint32_t publishes = 0;
+    climate.add_on_state_callback([&publishes](Climate&) { publishes++; });
+    climate.setup();
+    auto runUntil = [&climate](std::function<bool()> predicate, uint32_t timeoutMs)
+    {
+        uint32_t start = esphome::millis();
+        while (!predicate() && (esphome::millis() - start < timeoutMs))
+        {
+            climate.loop();
+            esphome::delay(1);
+        }
+        return predicate();
+    };
+    ASSERT_TRUE(runUntil([&publishes]() { return publishes > 0; }, 5000));
+    climate.make_call().set_mode(CLIMATE_MODE_COOL).set_target_temperature(19).perform();
+    ASSERT_TRUE(runUntil([&]() { return climate.target_temperature == 19.0f; }, 5000));
+    pty.stop();
+    EXPECT_TRUE(ac.isPowerOn());
+    EXPECT_EQ(ac.getMode(), 0x01);
+    EXPECT_EQ(ac.getSetPoint(), 19);
+}
+
+} // namespace
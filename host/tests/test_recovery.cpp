@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "haier_fixture.h"
+
+namespace {
+
+// Line faults injected for some time after first status, then time until the component
+// gets valid status again. Printed for comparison, limits follow from retry intervals
+class RecoveryTest : public HaierFixture
+{
+protected:
+    const esphome::haier::HaierClimate::ProtocolStatistics& statistics() const
+    {
+        return mClimate.get_protocol_statistics();
+    }
+    void SetUp() override
+    {
+        start();
+        ASSERT_TRUE(waitFirstStatus());
+        run(10000);
+    }
+    void clearFaults()
+    {
+        mUart.setDropRate(0.0);
+        mUart.setFlipRate(0.0);
+        mUart.setUnplugged(false);
+    }
+    // Time from the end of fault to the next valid frame
+    uint32_t measureRecovery(const char* name, uint32_t faultMs)
+    {
+        uint32_t recoveries = statistics().recoveries;
+        run(faultMs);
+        clearFaults();
+        uint32_t faultEnd = host::VirtualClock::now();
+        uint32_t frames = statistics().rxFrames;
+        EXPECT_TRUE(runUntil([&]() { return statistics().rxFrames > frames; }, 120000));
+        uint32_t recovered = host::VirtualClock::now() - faultEnd;
+        EXPECT_GT(statistics().recoveries, recoveries);
+        printf("%s for %u ms: %u resyncs, recovered in %u ms, %u ms after fault end\n", name, faultMs,
+               statistics().resyncs, statistics().lastRecoveryTime, recovered);
+        RecordProperty("recovery_ms", statistics().lastRecoveryTime);
+        RecordProperty("after_fault_ms", recovered);
+        return recovered;
+    }
+};
+
+TEST_F(RecoveryTest, DroppedBytes)
+{
+    mUart.setDropRate(0.05);
+    uint32_t recovered = measureRecovery("5% bytes dropped", 30000);
+    // First status retries back off while frames keep failing, interval grows to 16 s in 30 s
+    EXPECT_LT(recovered, 16000u + 1000u);
+}
+
+TEST_F(RecoveryTest, BitFlips)
+{
+    mUart.setFlipRate(0.05);
+    uint32_t recovered = measureRecovery("5% bytes with flipped bit", 30000);
+    EXPECT_LT(recovered, 16000u + 1000u);
+}
+
+TEST_F(RecoveryTest, ShortUnplug)
+{
+    mUart.setUnplugged(true);
+    uint32_t recovered = measureRecovery("Unplugged", 10000);
+    EXPECT_GT(statistics().resyncs, 0u);
+    // First status retries back off, 8 s interval after 1 + 2 + 4 s
+    EXPECT_LT(recovered, 8000u + 1000u);
+}
+
+TEST_F(RecoveryTest, LongUnplug)
+{
+    mUart.setUnplugged(true);
+    uint32_t recovered = measureRecovery("Unplugged", 180000);
+    // Retry interval is capped
+    EXPECT_LT(recovered, 30000u + 1000u);
+}
+
+// 0xFF 0xFF followed by wrong size is how noise usually looks to the decoder,
+// it is skipped without breaking frames and shouldn't make the protocol resync
+TEST_F(RecoveryTest, WrongSizeHeadersDontResync)
+{
+    const uint8_t noise[] = { 0xFF, 0xFF, 0x03, 0x00, 0xFF, 0xFF, 0xF0 };
+    uint32_t frames = statistics().rxFrames;
+    for (int i = 0; i < 20; ++i)
+    {
+        // Between frames, right after answer. Several bursts before the next status,
+        // so every one of them would be a consecutive failure
+        ASSERT_TRUE(runUntil([&]() { return statistics().rxFrames > frames; }, 10000));
+        frames = statistics().rxFrames;
+        for (int burst = 0; burst < 5; ++burst)
+        {
+            mUart.injectBytes(noise, sizeof(noise));
+            run(100);
+        }
+    }
+    run(5000);
+    EXPECT_GE(mClimate.get_decoder_statistics().wrongSizeErrors, 200u);
+    EXPECT_EQ(statistics().resyncs, 0u);
+    EXPECT_EQ(statistics().answerTimeouts, 0u);
+}
+
+} // namespace
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "haier_fixture.h"
+#include "haier_unit.h"
+
+using namespace esphome::climate;
+
+namespace {
+
+// First boot runs in the fixture instance, reboot is a new instance with the same name
+// reading the same preferences. restore_status is on by default in YAML only
+class RestoreTest : public HaierFixture
+{
+protected:
+    void firstBoot()
+    {
+        mAc.setPower(true);
+        mAc.setMode(0x04);
+        mAc.setSetPoint(25);
+        mClimate.set_restore_status(true);
+        start();
+        ASSERT_TRUE(waitFirstStatus());
+        ASSERT_EQ(mClimate.mode, CLIMATE_MODE_DRY);
+        // Save interval
+        run(61000);
+        ASSERT_EQ(host::getPreferences().getSaves(), 1u);
+    }
+    // Time from setup() to the first published state
+    uint32_t measureFirstState(HaierUnit& unit)
+    {
+        uint32_t setupTime = host::VirtualClock::now();
+        unit.climate.setup();
+        while ((unit.publishes == 0) && (host::VirtualClock::now() - setupTime < 10000))
+        {
+            host::VirtualClock::advance(1);
+            unit.climate.loop();
+        }
+        return host::VirtualClock::now() - setupTime;
+    }
+};
+
+TEST_F(RestoreTest, StoredStateIsPublishedAtSetup)
+{
+    firstBoot();
+    HaierUnit reboot("Haier AC");
+    reboot.climate.set_restore_status(true);
+    // AC was switched off by remote while ESP was rebooting
+    uint32_t firstState = measureFirstState(reboot);
+    printf("with stored status: first state after %u ms\n", firstState);
+    EXPECT_EQ(firstState, 0u);
+    EXPECT_EQ(reboot.climate.mode, CLIMATE_MODE_DRY);
+    EXPECT_EQ(reboot.climate.target_temperature, 25.0f);
+    // Provisional state is replaced by the AC answer
+    for (uint32_t i = 0; (i < 5000) && (reboot.publishes < 2); ++i)
+    {
+        host::VirtualClock::advance(1);
+        reboot.climate.loop();
+    }
+    EXPECT_EQ(reboot.climate.mode, CLIMATE_MODE_OFF);
+}
+
+TEST_F(RestoreTest, WithoutRestoreFirstStateWaitsForAc)
+{
+    firstBoot();
+    HaierUnit reboot("Haier AC");
+    reboot.climate.set_restore_status(false);
+    uint32_t firstState = measureFirstState(reboot);
+    printf("without stored status: first state after %u ms\n", firstState);
+    EXPECT_GE(firstState, 2000u);
+    EXPECT_EQ(reboot.climate.mode, CLIMATE_MODE_OFF);
+}
+
+TEST_F(RestoreTest, SavesAreCoalesced)
+{
+    firstBoot();
+    uint32_t saves = host::getPreferences().getSaves();
+    // Set point changed every 2 s and room temperature every second for 10 minutes.
+    // Set point cycle is not a divisor of save interval, so every save sees new settings
+    for (int i = 0; i < 300; ++i)
+    {
+        mAc.setSetPoint(20 + i % 7);
+        mAc.setRoomTemperature(20 + i % 7);
+        run(1000);
+        mAc.setRoomTemperature(21 + i % 7);
+        run(1000);
+    }
+    // One save per interval at most
+    EXPECT_LE(host::getPreferences().getSaves() - saves, 10u);
+    EXPECT_GE(host::getPreferences().getSaves() - saves, 5u);
+}
+
+TEST_F(RestoreTest, RoomTemperatureChangeIsNotSaved)
+{
+    firstBoot();
+    uint32_t saves = host::getPreferences().getSaves();
+    for (int i = 0; i < 300; ++i)
+    {
+        mAc.setRoomTemperature(20 + i % 7);
+        run(1000);
+    }
+    EXPECT_EQ(host::getPreferences().getSaves(), saves);
+}
+
+} // namespace
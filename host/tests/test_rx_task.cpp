@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "esphome/core/log.h"
+#include "haier_fixture.h"
+
+namespace {
+
+// Component built with rx_task: true. The task is a thread that runs once per ms of
+// virtual time before loop(), see HaierFixture::run()
+class RxTaskTest : public HaierFixture
+{
+protected:
+    const esphome::haier::HaierClimate::ProtocolStatistics& statistics() const
+    {
+        return mClimate.get_protocol_statistics();
+    }
+};
+
+TEST_F(RxTaskTest, StatusAndControlGoThroughTask)
+{
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    mClimate.make_call().set_target_temperature(24).perform();
+    run(3000);
+    EXPECT_EQ(mAc.getSetPoint(), 24);
+    EXPECT_EQ(mClimate.target_temperature, 24.0f);
+    EXPECT_GT(statistics().rxBytes, 0u);
+}
+
+// Decoder runs in the task, its errors are logged by loop()
+TEST_F(RxTaskTest, DecoderErrorsAreLoggedOnlyFromLoop)
+{
+    const uint8_t wrongSize[] = { 0xFF, 0xFF, 0x03 };
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    uint32_t warnings = host::getLogLines(ESPHOME_LOG_LEVEL_WARN);
+    mUart.setFlipRate(0.01);
+    for (int i = 0; i < 30; ++i)
+    {
+        mUart.injectBytes(wrongSize, sizeof(wrongSize));
+        run(1000);
+    }
+    mUart.setFlipRate(0.0);
+    run(10000);
+    const esphome::haier::HaierFrameDecoder::Statistics& decoder = mClimate.get_decoder_statistics();
+    EXPECT_GT(decoder.checksumErrors, 0u);
+    EXPECT_GE(decoder.wrongSizeErrors, 30u);
+    EXPECT_GT(host::getLogLines(ESPHOME_LOG_LEVEL_WARN), warnings);
+    EXPECT_EQ(host::getForeignThreadLogLines(), 0u);
+}
+
+TEST_F(RxTaskTest, IncompleteFrameTimesOutInTask)
+{
+    // Header and size of status frame, rest never comes
+    const uint8_t partial[] = { 0xFF, 0xFF, 0x25, 0x00, 0x00 };
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    run(2000);
+    uint32_t frames = statistics().rxFrames;
+    mUart.injectBytes(partial, sizeof(partial));
+    run(30000);
+    EXPECT_EQ(statistics().packetTimeouts, 1u);
+    EXPECT_GT(statistics().rxFrames, frames);
+    EXPECT_EQ(host::getForeignThreadLogLines(), 0u);
+}
+
+// loop() blocked for a while, task keeps reading and drops frames the queue can't hold
+TEST_F(RxTaskTest, QueueOverflowWhileLoopIsBlocked)
+{
+    mAc.setUnsolicitedInterval(50);
+    start();
+    ASSERT_TRUE(waitFirstStatus());
+    for (int i = 0; i < 1000; ++i)
+    {
+        host::VirtualClock::advance(1);
+        host::runTasks();
+    }
+    EXPECT_GT(statistics().rxQueueOverflows, 0u);
+    uint32_t publishes = mPublishes;
+    mAc.setRoomTemperature(28);
+    run(1000);
+    EXPECT_GT(mPublishes, publishes);
+    EXPECT_EQ(mClimate.current_temperature, 28.0f);
+}
+
+} // namespace
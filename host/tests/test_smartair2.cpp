@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include "haier_protocol.h"
+#include "haier_climate_state.h"
+#include "haier_crc.h"
+
+using namespace esphome::climate;
+using esphome::haier::HaierClimateState;
+using esphome::haier::HaierControlRequest;
+using esphome::haier::HaierProtocol;
+
+namespace {
+
+// Protocol policy alone, without component and UART
+class SmartAir2Test : public ::testing::Test
+{
+protected:
+    // Status answer with the control bytes of message
+    void makeStatus(const uint8_t* control)
+    {
+        memcpy(mStatus, control, HaierProtocol::CONTROL_PACKET_SIZE);
+        HaierProtocol::MsgType::set(mStatus, HaierProtocol::hpAnswerRequestStatus);
+        HaierProtocol::Cntrl::set(mStatus, 0x7F);
+    }
+
+    uint8_t                         mControl[HaierProtocol::MAX_FRAME_SIZE] = {};
+    uint8_t                         mStatus[HaierProtocol::MAX_FRAME_SIZE] = {};
+    HaierProtocol::ControlContext   mContext = HaierProtocol::INITIAL_CONTROL_CONTEXT;
+};
+
+TEST_F(SmartAir2Test, ControlDecodesToRequestedState)
+{
+    HaierControlRequest request;
+    request.mode = CLIMATE_MODE_HEAT;
+    request.fanMode = CLIMATE_FAN_LOW;
+    request.swingMode = CLIMATE_SWING_VERTICAL;
+    request.targetTemperature = 23;
+    ASSERT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceChanged);
+    EXPECT_EQ(HaierProtocol::MsgLength::get(mControl), HaierProtocol::CONTROL_PACKET_SIZE);
+    EXPECT_EQ(HaierProtocol::Cntrl::get(mControl), 0);
+    makeStatus(mControl);
+    HaierProtocol::RoomTemperature::set(mStatus, 26);
+    HaierClimateState state = { CLIMATE_MODE_OFF, {}, CLIMATE_SWING_OFF, 0, 0 };
+    HaierProtocol::decodeStatus(mStatus, state, mContext);
+    EXPECT_EQ(state.mode, CLIMATE_MODE_HEAT);
+    ASSERT_TRUE(state.fanMode.has_value());
+    EXPECT_EQ(*state.fanMode, CLIMATE_FAN_LOW);
+    EXPECT_EQ(state.swingMode, CLIMATE_SWING_VERTICAL);
+    EXPECT_EQ(state.targetTemperature, 23.0f);
+    EXPECT_EQ(state.currentTemperature, 26.0f);
+    EXPECT_EQ(mContext.otherModesFanSpeed, HaierProtocol::FanLow);
+    EXPECT_TRUE(HaierProtocol::matchesControl(mStatus, mControl));
+}
+
+TEST_F(SmartAir2Test, SameRequestIsUnchanged)
+{
+    HaierControlRequest request;
+    request.mode = CLIMATE_MODE_COOL;
+    request.targetTemperature = 20;
+    ASSERT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceChanged);
+    EXPECT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceUnchanged);
+    EXPECT_EQ(HaierProtocol::encodeControl(mControl, request, false, mContext), HaierProtocol::ceChanged);
+    EXPECT_EQ(HaierProtocol::DisplayOff::get(mControl), 1);
+}
+
+TEST_F(SmartAir2Test, UnsupportedModesAreRejected)
+{
+    HaierControlRequest request;
+    request.mode = CLIMATE_MODE_HEAT_COOL;
+    EXPECT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceUnsupportedMode);
+    request = HaierControlRequest();
+    request.fanMode = CLIMATE_FAN_DIFFUSE;
+    EXPECT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceUnsupportedFanMode);
+}
+
+// Fan only mode uses the speed remembered from the last fan only status, auto is not accepted there
+TEST_F(SmartAir2Test, FanOnlyModeKeepsItsOwnFanSpeed)
+{
+    mContext.fanModeFanSpeed = HaierProtocol::FanHigh;
+    HaierControlRequest request;
+    request.mode = CLIMATE_MODE_FAN_ONLY;
+    request.fanMode = CLIMATE_FAN_AUTO;
+    ASSERT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceChanged);
+    EXPECT_EQ(HaierProtocol::FanSpeed::get(mControl), HaierProtocol::FanHigh);
+}
+
+TEST_F(SmartAir2Test, AnswerForOffAcIgnoresOtherFields)
+{
+    HaierControlRequest request;
+    request.mode = CLIMATE_MODE_OFF;
+    request.targetTemperature = 25;
+    ASSERT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceChanged);
+    makeStatus(mControl);
+    HaierProtocol::SetPoint::set(mStatus, 4);
+    EXPECT_TRUE(HaierProtocol::matchesControl(mStatus, mControl));
+    HaierProtocol::AcPower::set(mStatus, 1);
+    EXPECT_FALSE(HaierProtocol::matchesControl(mStatus, mControl));
+}
+
+TEST_F(SmartAir2Test, StatusRequestAndAnswerTypes)
+{
+    uint8_t request[HaierProtocol::MAX_FRAME_SIZE] = {};
+    uint8_t size = HaierProtocol::encodeStatusRequest(request);
+    EXPECT_EQ(size, HaierProtocol::HEADER_SIZE);
+    EXPECT_EQ(HaierProtocol::getMessageSize(request), size);
+    EXPECT_EQ(HaierProtocol::MsgType::get(request), HaierProtocol::hpCommandStatus);
+    EXPECT_EQ(HaierProtocol::getAnswerType(request), HaierProtocol::atUnknown);
+    makeStatus(mControl);
+    EXPECT_EQ(HaierProtocol::getAnswerType(mStatus), HaierProtocol::atStatus);
+    HaierProtocol::MsgType::set(mStatus, HaierProtocol::hpAnswerError);
+    EXPECT_EQ(HaierProtocol::getAnswerType(mStatus), HaierProtocol::atError);
+    HaierProtocol::MsgType::set(mStatus, HaierProtocol::hpAnswerConfirm);
+    EXPECT_EQ(HaierProtocol::getAnswerType(mStatus), HaierProtocol::atConfirm);
+}
+
+TEST_F(SmartAir2Test, SettingsCrcIgnoresRoomTemperature)
+{
+    HaierControlRequest request;
+    request.mode = CLIMATE_MODE_COOL;
+    request.targetTemperature = 22;
+    ASSERT_EQ(HaierProtocol::encodeControl(mControl, request, true, mContext), HaierProtocol::ceChanged);
+    makeStatus(mControl);
+    HaierProtocol::RoomTemperature::set(mStatus, 25);
+    uint16_t crc = HaierProtocol::getSettingsCrc(mStatus, HaierProtocol::CONTROL_PACKET_SIZE);
+    HaierProtocol::RoomTemperature::set(mStatus, 0);
+    EXPECT_EQ(crc, esphome::haier::crc16(mStatus, HaierProtocol::CONTROL_PACKET_SIZE));
+    HaierProtocol::RoomTemperature::set(mStatus, 30);
+    EXPECT_EQ(HaierProtocol::getSettingsCrc(mStatus, HaierProtocol::CONTROL_PACKET_SIZE), crc);
+    HaierProtocol::SetPoint::set(mStatus, 7);
+    EXPECT_NE(HaierProtocol::getSettingsCrc(mStatus, HaierProtocol::CONTROL_PACKET_SIZE), crc);
+}
+
+TEST_F(SmartAir2Test, SignalReport)
+{
+    uint8_t report[HaierProtocol::SIGNAL_PACKET_SIZE];
+    HaierProtocol::encodeSignalReport(report, true, 0);
+    EXPECT_EQ(HaierProtocol::MsgLength::get(report), HaierProtocol::SIGNAL_PACKET_SIZE);
+    EXPECT_EQ(HaierProtocol::MsgType::get(report), HaierProtocol::hpCommandReportNetworkStatus);
+    EXPECT_EQ(HaierProtocol::NetworkStatus::get(report), 0);
+    EXPECT_EQ(HaierProtocol::SignalLevel::get(report), 100);
+    HaierProtocol::encodeSignalReport(report, false, -50);
+    EXPECT_EQ(HaierProtocol::NetworkStatus::get(report), 1);
+    EXPECT_EQ(HaierProtocol::SignalLevel::get(report), 0);
+}
+
+} // namespace
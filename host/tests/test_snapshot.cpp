@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "haier_status_snapshot.h"
+
+using esphome::haier::HaierStatusSnapshot;
+using esphome::haier::HaierProtocol;
+
+namespace {
+
+// Every write is HaierProtocol::MAX_FRAME_SIZE bytes of the same value, so a torn copy has different bytes
+void fill(uint8_t* data, uint8_t value)
+{
+    memset(data, value, HaierProtocol::MAX_FRAME_SIZE);
+}
+
+// Write number repeated over the whole frame
+void fillCounter(uint8_t* data, uint32_t counter)
+{
+    for (size_t i = 0; i < HaierProtocol::MAX_FRAME_SIZE; i += sizeof(counter))
+        memcpy(data + i, &counter, sizeof(counter));
+}
+
+TEST(SnapshotTest, NothingToReadBeforeFirstWrite)
+{
+    HaierStatusSnapshot snapshot;
+    uint8_t data[4];
+    EXPECT_FALSE(snapshot.read(data, 0, sizeof(data)));
+}
+
+TEST(SnapshotTest, ReadReturnsLastWrite)
+{
+    HaierStatusSnapshot snapshot;
+    uint8_t data[HaierProtocol::MAX_FRAME_SIZE];
+    for (uint8_t value = 1; value < 5; ++value)
+    {
+        fill(data, value);
+        snapshot.write(data, 10);
+        uint8_t result[4] = {};
+        ASSERT_TRUE(snapshot.read(result, 6, sizeof(result)));
+        EXPECT_EQ(result[0], value);
+        EXPECT_EQ(result[3], value);
+        EXPECT_EQ(snapshot.getSequence(), value * 2u);
+    }
+    uint8_t result[4];
+    // Past the end of written size
+    EXPECT_FALSE(snapshot.read(result, 7, sizeof(result)));
+}
+
+// One writer (loop()) and several readers (other tasks) at full speed for a fixed time,
+// so readers get preempted in the middle of a copy even on one core
+TEST(SnapshotTest, ConcurrentReadersNeverSeeTornOrOlderStatus)
+{
+    const auto DURATION = std::chrono::milliseconds(300);
+    const int READERS = 3;
+    HaierStatusSnapshot snapshot;
+    std::atomic<int> started(0);
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> reads(0);
+    std::atomic<uint32_t> torn(0);
+    std::atomic<uint32_t> older(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < READERS; ++i)
+    {
+        readers.emplace_back([&]()
+        {
+            uint8_t data[HaierProtocol::MAX_FRAME_SIZE];
+            uint32_t last = 0;
+            uint64_t count = 0;
+            started++;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                if (!snapshot.read(data, 0, sizeof(data)))
+                    continue;
+                count++;
+                uint32_t counter;
+                memcpy(&counter, data, sizeof(counter));
+                if (memcmp(data, data + sizeof(counter), sizeof(data) - sizeof(counter)) != 0)
+                    torn++;
+                else if (counter < last)
+                    older++;
+                last = counter;
+            }
+            reads += count;
+        });
+    }
+    while (started < READERS)
+        std::this_thread::yield();
+    uint8_t data[HaierProtocol::MAX_FRAME_SIZE];
+    uint32_t writes = 0;
+    auto end = std::chrono::steady_clock::now() + DURATION;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        for (int i = 0; i < 64; ++i)
+        {
+            fillCounter(data, ++writes);
+            snapshot.write(data, sizeof(data));
+        }
+        std::this_thread::yield();
+    }
+    done = true;
+    for (std::thread& reader : readers)
+        reader.join();
+    EXPECT_EQ(torn.load(), 0u);
+    EXPECT_EQ(older.load(), 0u);
+    EXPECT_GT(reads.load(), 1000u);
+    EXPECT_EQ(snapshot.getSequence(), writes * 2);
+    printf("%u writes, %llu reads by %d readers\n", writes, (unsigned long long)reads.load(), READERS);
+}
+
+} // namespace
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "haier_fixture.h"
+#include "haier_unit.h"
+
+namespace {
+
+// Time from setup() to the first published state, printed for comparison between AC behaviours
+class StartupTest : public HaierFixture
+{
+protected:
+    uint32_t measureFirstState(const char* name)
+    {
+        auto start = std::chrono::steady_clock::now();
+        this->start();
+        double setupTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        EXPECT_TRUE(waitFirstStatus());
+        uint32_t firstState = mLastPublishTime - mSetupTime;
+        printf("%s: setup() %.0f us, first state after %u ms\n", name, setupTime, firstState);
+        RecordProperty("first_state_ms", firstState);
+        // Only real time spent in setup() is the blocking part
+        EXPECT_LT(setupTime, 10000.0);
+        return firstState;
+    }
+};
+
+TEST_F(StartupTest, AcAnsweringOnlyRequestsIsPolledAfterWarmUp)
+{
+    uint32_t firstState = measureFirstState("quiet AC");
+    // Warm up, request and answer of 40 bytes at 9600 baud
+    EXPECT_GE(firstState, 2000u);
+    EXPECT_LT(firstState, 2200u);
+    EXPECT_EQ(mClimate.get_protocol_statistics().firstStatusTime, firstState);
+}
+
+TEST_F(StartupTest, AcSendingTrafficEndsWarmUpEarly)
+{
+    mAc.setUnsolicitedInterval(300);
+    uint32_t firstState = measureFirstState("AC sending status every 300 ms");
+    // First valid frame ends warm up, status is requested right after it
+    EXPECT_LT(firstState, 500u);
+}
+
+TEST_F(StartupTest, ShortWarmUpIsUsed)
+{
+    mClimate.set_warm_up_time(500);
+    uint32_t firstState = measureFirstState("warm up 500 ms");
+    EXPECT_GE(firstState, 500u);
+    EXPECT_LT(firstState, 700u);
+}
+
+// Every instance warms up in its own state machine, so warm ups don't add up
+TEST(StartupInstancesTest, WarmUpsRunInParallel)
+{
+    host::resetRuntime();
+    host::VirtualClock::set(1000);
+    std::vector<std::unique_ptr<HaierUnit>> units;
+    const char* names[] = { "Living room", "Bedroom", "Office", "Kitchen" };
+    auto start = std::chrono::steady_clock::now();
+    for (const char* name : names)
+    {
+        units.emplace_back(new HaierUnit(name));
+        units.back()->climate.setup();
+    }
+    double setupTime = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_LT(setupTime, 10000.0);
+    uint32_t elapsed = 0;
+    auto allPublished = [&units]()
+    {
+        for (auto& unit : units)
+            if (unit->publishes == 0)
+                return false;
+        return true;
+    };
+    for (; !allPublished() && (elapsed < 10000); ++elapsed)
+    {
+        host::VirtualClock::advance(1);
+        for (auto& unit : units)
+            unit->climate.loop();
+    }
+    printf("4 instances: setup() %.0f us, all states after %u ms\n", setupTime, elapsed);
+    EXPECT_LT(elapsed, 2200u);
+}
+
+} // namespace
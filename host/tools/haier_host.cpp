@@ -0,0 +1,46 @@
+// Runs HaierClimate on the host against a serial device: pseudo-terminal of
+// haier_sim or USB-serial adapter connected to the AC.
+//
+// Usage: haier_host <device> [seconds]
+#include <cstdio>
+#include <cstdlib>
+#include "esphome/core/hal.h"
+#include "host_runtime.h"
+#include "pty_uart.h"
+#include "haier_climate.h"
+
+using namespace esphome;
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <device> [seconds]\n", argv[0]);
+        return 2;
+    }
+    uint32_t duration = argc > 2 ? atoi(argv[2]) * 1000 : 0;
+    host::setLogOutput(true);
+    host::SerialUart uart;
+    if (!uart.open(argv[1]))
+    {
+        perror("Can't open device");
+        return 1;
+    }
+    haier::HaierClimate climate(&uart);
+    climate.set_name("Haier AC");
+    climate.add_on_state_callback([](climate::Climate& state)
+    {
+        printf("mode: %d, target: %.0f, current: %.0f, fan: %d, swing: %d\n", state.mode, state.target_temperature,
+               state.current_temperature, state.fan_mode.has_value() ? (int)*state.fan_mode : -1, state.swing_mode);
+        fflush(stdout);
+    });
+    climate.setup();
+    climate.dump_config();
+    uint32_t start = millis();
+    while ((duration == 0) || (millis() - start < duration))
+    {
+        climate.loop();
+        delay(1);
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Replays UART capture from HaierClimate::dump_capture() log output (hex or binary format)
+// through the decoder and status handling, faster than real time.
+//
+// Usage: haier_replay [--frames] [--log] <log file | ->
+//   --frames   capture was made with rx_task, received records are frames without 0xFF 0xFF
+//   --log      print component log
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "host_runtime.h"
+#include "capture_replay.h"
+
+using namespace esphome;
+
+int main(int argc, char** argv)
+{
+    bool addFramePrefix = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--frames") == 0)
+            addFramePrefix = true;
+        else if (strcmp(argv[i], "--log") == 0)
+            host::setLogOutput(true);
+        else
+            path = argv[i];
+    }
+    if (path == nullptr)
+    {
+        fprintf(stderr, "Usage: %s [--frames] [--log] <log file | ->\n", argv[0]);
+        return 2;
+    }
+    std::ifstream file;
+    if (strcmp(path, "-") != 0)
+    {
+        file.open(path);
+        if (!file)
+        {
+            perror("Can't open log");
+            return 1;
+        }
+    }
+    std::istream& input = strcmp(path, "-") == 0 ? std::cin : file;
+    host::CaptureParser parser;
+    std::string line;
+    for (unsigned number = 1; std::getline(input, line); ++number)
+    {
+        if (!parser.addLine(line))
+            fprintf(stderr, "Line %u: broken capture line\n", number);
+    }
+    if (!parser.finish())
+        fprintf(stderr, "Binary capture is truncated\n");
+    host::ReplayUart uart;
+    haier::HaierClimate climate(&uart);
+    climate.set_name("Haier AC");
+    auto start = std::chrono::steady_clock::now();
+    host::ReplayResult result = host::replayCapture(parser.getRecords(), uart, climate, addFramePrefix);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("records: %u received, %u sent, %llu bytes received in %.1f s of capture\n", result.rxRecords,
+           result.txRecords, (unsigned long long)result.rxBytes, result.duration / 1000.0);
+    printf("frames: %u valid, %u recovered, %u dropped\n", result.protocol.rxFrames, result.decoder.recoveredFrames,
+           result.decoder.droppedFrames);
+    printf("errors: %u checksum, %u CRC, %u wrong size, %u packet timeouts\n", result.decoder.checksumErrors,
+           result.decoder.crcErrors, result.decoder.wrongSizeErrors, result.protocol.packetTimeouts);
+    printf("status answers: %u published, %u suppressed, %u held, %u state publishes\n", result.publish.published,
+           result.publish.suppressed, result.publish.held, result.publishes);
+    if (result.publishes > 0)
+        printf("last state: mode %d, target %.0f, current %.0f, fan %d, swing %d\n", climate.mode,
+               climate.target_temperature, climate.current_temperature,
+               climate.fan_mode.has_value() ? (int)*climate.fan_mode : -1, climate.swing_mode);
+    printf("replay: %.3f ms wall, %.0fx real time\n", wall * 1000, wall > 0 ? result.duration / 1000.0 / wall : 0);
+    return 0;
+}
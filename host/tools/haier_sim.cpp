@@ -0,0 +1,59 @@
+// Simulated smartAir2 AC on a pseudo-terminal. Point haier_host (or anything
+// else that talks to a serial port) to the printed device to talk to it.
+//
+// Usage: haier_sim [--delay ms] [--silent] [--unsolicited ms]
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include "pty_uart.h"
+#include "simulated_ac.h"
+
+namespace {
+    volatile sig_atomic_t gStop = 0;
+    void onSignal(int) { gStop = 1; }
+}
+
+int main(int argc, char** argv)
+{
+    host::SimulatedAc ac;
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--delay") == 0) && (i + 1 < argc))
+            ac.setAnswerDelay(atoi(argv[++i]));
+        else if ((strcmp(argv[i], "--unsolicited") == 0) && (i + 1 < argc))
+            ac.setUnsolicitedInterval(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--silent") == 0)
+            ac.setSilent(true);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--delay ms] [--silent] [--unsolicited ms]\n", argv[0]);
+            return 2;
+        }
+    }
+    host::PtyAc pty(ac);
+    if (!pty.open())
+    {
+        perror("Can't create pseudo-terminal");
+        return 1;
+    }
+    printf("%s\n", pty.getSlavePath().c_str());
+    fflush(stdout);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    uint32_t lastRequests = 0, lastControls = 0;
+    while (!gStop)
+    {
+        pty.poll(10);
+        const host::SimulatedAc::Statistics& statistics = ac.getStatistics();
+        if ((statistics.statusRequests != lastRequests) || (statistics.controlCommands != lastControls))
+        {
+            lastRequests = statistics.statusRequests;
+            lastControls = statistics.controlCommands;
+            fprintf(stderr, "requests: %u, controls: %u, power: %d, mode: %u, fan: %u, set point: %u, display: %s\n",
+                    lastRequests, lastControls, ac.isPowerOn(), ac.getMode(), ac.getFanSpeed(), ac.getSetPoint(),
+                    ac.isDisplayOff() ? "off" : "on");
+        }
+    }
+    return 0;
+}
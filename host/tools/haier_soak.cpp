@@ -0,0 +1,172 @@
+// Soak run in virtual time: days of polling with hourly line faults, AC silence
+// and control calls, faster than real time. Exit code is 1 if some unit didn't
+// recover after a fault or didn't end up with the last requested set point.
+//
+// Every hour of virtual time:
+//   minutes  0..40  normal traffic
+//   minutes 40..45  1 of 500 bytes lost or with one bit flipped
+//   minutes 45..50  1 of 50 bytes lost or flipped, noise bursts
+//   minutes 50..53  cable unplugged
+//   minutes 55..57  AC doesn't answer
+// Set point is changed every 7 minutes, room temperature every 11 minutes.
+//
+// Usage: haier_soak [--hours N] [--units N] [--start ms] [--unsolicited ms] [--seed N] [--log]
+//   --start    virtual clock at setup(), 0xFFF00000 overflows millis() after 17 minutes
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "host_runtime.h"
+#include "haier_unit.h"
+
+namespace {
+
+const uint32_t MINUTE = 60000;
+const uint32_t HOUR = 60 * MINUTE;
+const uint8_t MIN_SET_POINT = 16;
+
+struct SoakUnit
+{
+    explicit SoakUnit(const char* name) : unit(name), setPoint(0), stuckHours(0), lastRxFrames(0) {}
+    HaierUnit   unit;
+    uint8_t     setPoint;       // Last requested
+    uint32_t    stuckHours;     // Hours that ended without valid frames in last minutes
+    uint32_t    lastRxFrames;   // At the end of last fault
+};
+
+void setFaults(SoakUnit& soak, uint32_t minute, uint32_t index)
+{
+    host::SimulatedUart& uart = soak.unit.uart;
+    double rate = 0;
+    if ((minute >= 40) && (minute < 45))
+        rate = 0.002;
+    else if ((minute >= 45) && (minute < 50))
+        rate = 0.02;
+    uart.setDropRate(rate);
+    uart.setFlipRate(rate);
+    uart.setUnplugged((minute >= 50) && (minute < 53));
+    soak.unit.ac.setSilent((minute >= 55) && (minute < 57));
+    if ((minute >= 45) && (minute < 50) && (index % 4 == 0))
+        uart.injectNoise(64);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t hours = 72;
+    uint32_t unitCount = 1;
+    uint32_t startTime = 1000;
+    uint32_t unsolicited = 0;
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if ((strcmp(argv[i], "--hours") == 0) && (i + 1 < argc))
+            hours = strtoul(argv[++i], nullptr, 0);
+        else if ((strcmp(argv[i], "--units") == 0) && (i + 1 < argc))
+            unitCount = strtoul(argv[++i], nullptr, 0);
+        else if ((strcmp(argv[i], "--start") == 0) && (i + 1 < argc))
+            startTime = strtoul(argv[++i], nullptr, 0);
+        else if ((strcmp(argv[i], "--unsolicited") == 0) && (i + 1 < argc))
+            unsolicited = strtoul(argv[++i], nullptr, 0);
+        else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc))
+            seed = strtoul(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--log") == 0)
+            host::setLogOutput(true);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--hours N] [--units N] [--start ms] [--unsolicited ms] [--seed N] [--log]\n", argv[0]);
+            return 2;
+        }
+    }
+    if ((hours == 0) || (unitCount == 0))
+    {
+        fprintf(stderr, "Nothing to run\n");
+        return 2;
+    }
+    host::VirtualClock::set(startTime);
+    std::vector<std::unique_ptr<SoakUnit>> units;
+    for (uint32_t i = 0; i < unitCount; ++i)
+    {
+        char name[16];
+        snprintf(name, sizeof(name), "Unit %u", i + 1);
+        units.emplace_back(new SoakUnit(name));
+        units.back()->unit.uart.setSeed(seed + i);
+        units.back()->unit.ac.setUnsolicitedInterval(unsolicited);
+        units.back()->unit.climate.setup();
+    }
+    printf("%u units, %u hours from %" PRIu32 " ms\n", unitCount, hours, startTime);
+    auto start = std::chrono::steady_clock::now();
+    uint32_t changes = 0;
+    for (uint32_t hour = 0; hour < hours; ++hour)
+    {
+        for (uint32_t minute = 0; minute < 60; ++minute)
+        {
+            uint32_t elapsedMinutes = hour * 60 + minute;
+            for (auto& soak : units)
+            {
+                setFaults(*soak, minute, elapsedMinutes);
+                if ((elapsedMinutes % 7 == 6) && (minute < 40))
+                {
+                    soak->setPoint = MIN_SET_POINT + changes++ % 15;
+                    soak->unit.climate.make_call().set_target_temperature(soak->setPoint).perform();
+                }
+                if (elapsedMinutes % 11 == 10)
+                    soak->unit.ac.setRoomTemperature(18 + elapsedMinutes % 9);
+                if (minute == 57)
+                    soak->lastRxFrames = soak->unit.climate.get_protocol_statistics().rxFrames;
+            }
+            for (uint32_t ms = 0; ms < MINUTE; ++ms)
+            {
+                host::VirtualClock::advance(1);
+                for (auto& soak : units)
+                    soak->unit.climate.loop();
+            }
+        }
+        // Last three minutes of the hour are without faults
+        for (auto& soak : units)
+        {
+            if (soak->unit.climate.get_protocol_statistics().rxFrames == soak->lastRxFrames)
+                soak->stuckHours++;
+        }
+        if ((hour + 1) % 24 == 0)
+            printf("day %u done\n", (hour + 1) / 24);
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double simulated = (double)hours * HOUR / 1000;
+    uint64_t totalFrames = 0;
+    bool failed = false;
+    for (auto& soak : units)
+    {
+        const esphome::haier::HaierClimate& climate = soak->unit.climate;
+        const auto& protocol = climate.get_protocol_statistics();
+        const auto& decoder = climate.get_decoder_statistics();
+        totalFrames += protocol.rxFrames;
+        printf("%s: %" PRIu32 " frames, %" PRIu32 " answer timeouts, %" PRIu32 " protocol resets, "
+               "%" PRIu32 " packet timeouts, %" PRIu32 " resyncs\n",
+               climate.get_name().c_str(), protocol.rxFrames, protocol.answerTimeouts, protocol.protocolResets,
+               protocol.packetTimeouts, protocol.resyncs);
+        printf("    %" PRIu32 " checksum, %" PRIu32 " wrong size errors, %" PRIu32 " recovered frames\n",
+               decoder.checksumErrors, decoder.wrongSizeErrors, decoder.recoveredFrames);
+        printf("    %" PRIu32 " recoveries, max %" PRIu32 " ms, %" PRIu32 " publishes\n",
+               protocol.recoveries, protocol.maxRecoveryTime, soak->unit.publishes);
+        if (soak->stuckHours > 0)
+        {
+            printf("    FAILED: no valid frames after faults in %u hours\n", soak->stuckHours);
+            failed = true;
+        }
+        if ((soak->setPoint != 0) && ((soak->unit.ac.getSetPoint() != soak->setPoint) ||
+                                      (climate.target_temperature != soak->setPoint)))
+        {
+            printf("    FAILED: set point %u requested, AC has %u, climate shows %.0f\n",
+                   soak->setPoint, soak->unit.ac.getSetPoint(), climate.target_temperature);
+            failed = true;
+        }
+    }
+    printf("%.0f s simulated in %.2f s (%.0fx), %.0f simulated frames/s\n",
+           simulated, wall, simulated / wall, totalFrames / wall);
+    return failed ? 1 : 0;
+}